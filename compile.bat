@@ -11,11 +11,27 @@ set PATH=%PATH%;%COMPILER_DIR%
 :: > Cleaning latest build
 :: ---------------------------
 cmd /c if exist main.exe del /F main.exe
+cmd /c if exist batch.exe del /F batch.exe
 :: .
 :: > Compiling program
 :: --------------------------
 g++ -o main.exe lib/imgui.o lib/jsoncpp.o ./src/*.cpp -mconsole -v -s -O3 -I%INCLUDE_DIR% -L%LIB_DIR% -lmingw32 -lSDL2main -lSDL2 -lkernel32 -lwinmm -lgdi32
 :: .
+:: > Compiling headless scenario evaluator
+:: every source but the app's entry point and window, and no SDL2main since it never opens one
+:: --------------------------
+setlocal EnableDelayedExpansion
+set BATCH_SOURCES=
+for %%f in (src\*.cpp) do if /I not "%%~nxf"=="main.cpp" if /I not "%%~nxf"=="app.cpp" set BATCH_SOURCES=!BATCH_SOURCES! %%f
+g++ -o batch.exe lib/imgui.o lib/jsoncpp.o !BATCH_SOURCES! ./src/batch/batch.cpp -mconsole -s -O3 -I%INCLUDE_DIR% -L%LIB_DIR% -lmingw32 -lSDL2 -lkernel32 -lwinmm -lgdi32
+endlocal
+:: .
+:: > Compiling the benchmark build, only with "compile.bat bench"
+:: allocation tracking replaces operator new and the sdl and imgui allocators, so it stays out of main.exe
+:: --------------------------
+cmd /c if exist bench.exe del /F bench.exe
+if /I "%1"=="bench" g++ -o bench.exe lib/imgui.o lib/jsoncpp.o ./src/*.cpp -mconsole -s -O3 -DALLOC_TRACKING -I%INCLUDE_DIR% -L%LIB_DIR% -lmingw32 -lSDL2main -lSDL2 -lkernel32 -lwinmm -lgdi32
+:: .
 :: > Executing program
 :: -------------------------
 cmd /c if exist main.exe main.exe
@@ -0,0 +1,115 @@
+/*
+ *  alloc.cpp - heap allocation counting for finding per frame allocations
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// every thread counts its own allocations, so the frame loop isnt blamed for the autosave or loaders
+static thread_local AllocTracker::Counts counts = {};
+
+#ifdef ALLOC_TRACKING
+// the replacement operator new, every new in the program goes through these
+void* operator new(size_t size) {
+    counts.news++;
+    counts.bytes += size;
+
+    void* memory = malloc(size ? size : 1);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    counts.news++;
+    counts.bytes += size;
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+
+// imgui and sdl take allocator functions, so theirs are counted separately
+static void* imguiAlloc(size_t size, void*) {
+    counts.imgui++;
+    counts.bytes += size;
+    return malloc(size);
+}
+
+static void imguiFree(void* memory, void*) {
+    free(memory);
+}
+
+static void* sdlMalloc(size_t size) {
+    counts.sdl++;
+    counts.bytes += size;
+    return malloc(size);
+}
+
+static void* sdlCalloc(size_t count, size_t size) {
+    counts.sdl++;
+    counts.bytes += count * size;
+    return calloc(count, size);
+}
+
+// growing a buffer counts as an allocation too, it usually moves
+static void* sdlRealloc(void* memory, size_t size) {
+    counts.sdl++;
+    counts.bytes += size;
+    return realloc(memory, size);
+}
+
+static void sdlFree(void* memory) {
+    free(memory);
+}
+#endif
+
+void AllocTracker::install() {
+#ifdef ALLOC_TRACKING
+    ImGui::SetAllocatorFunctions(imguiAlloc, imguiFree);
+    SDL_SetMemoryFunctions(sdlMalloc, sdlCalloc, sdlRealloc, sdlFree);
+#endif
+}
+
+bool AllocTracker::enabled() {
+#ifdef ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocTracker::Counts AllocTracker::current() {
+    return counts;
+}
+
+AllocTracker::Counts AllocTracker::since(Counts start) {
+    Counts now = counts;
+    return Counts{now.news - start.news, now.imgui - start.imgui, now.sdl - start.sdl, now.bytes - start.bytes};
+}
+
+uint64_t AllocTracker::Counts::total() {
+    return this->news + this->imgui + this->sdl;
+}
@@ -0,0 +1,121 @@
+/*
+ *  annealing.cpp - chains, cooling and live progress shared by the optimizers
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+Annealing::Annealing() {
+    this->cancelled = false;
+    this->chains = 0;
+    this->totalMoves = 1;
+    this->movesDone = 0;
+    this->chainMoves = 0;
+    this->batchSize = 1;
+    this->startTemperature = 1.0;
+    this->endTemperature = 1.0;
+}
+
+void Annealing::begin(int chains, int64_t chainMoves, int batchSize, double scale, double hot, double cold) {
+    this->chainMoves = chainMoves;
+    this->batchSize = batchSize;
+    this->startTemperature = scale * hot;
+    this->endTemperature = scale * cold;
+    this->movesDone = 0;
+
+    // the live view indexes the curves by the chain count, so they only ever change together
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->chains = chains;
+    this->totalMoves = std::max<int64_t>(1, chainMoves * chains);
+    this->curves.assign(chains * ANNEAL_CURVE, 0.0f);
+    this->reached.assign(chains, 0);
+}
+
+int Annealing::run(int seed, const std::function<double(Chain&)>& fn) {
+    int chains = this->chains;
+    std::vector<double> scores(chains);
+
+    Parallel::forRange(chains, 1, [&](int begin, int end) {
+        for (int index = begin; index < end; index++) {
+            Chain chain;
+            chain.index = index;
+            chain.random.seed((uint64_t) seed * 0x9E3779B97F4A7C15ull + index);
+            chain.chance = std::uniform_real_distribution<double>(0.0, 1.0);
+            chain.done = 0;
+            chain.temperature = this->startTemperature;
+
+            int64_t batches = std::max<int64_t>(1, (this->chainMoves + this->batchSize - 1) / this->batchSize);
+            chain.cooling = pow(this->endTemperature / this->startTemperature, 1.0 / batches);
+
+            scores[index] = fn(chain);
+        }
+    });
+
+    // ties go to the lowest chain, so a seed always gives the same result on the same machine
+    int best = 0;
+    for (int index = 1; index < chains; index++) {
+        if (scores[index] > scores[best]) {
+            best = index;
+        }
+    }
+
+    return best;
+}
+
+int Annealing::batch(Chain& chain) {
+    if (this->cancelled) {
+        return 0;
+    }
+
+    return std::min<int64_t>(this->batchSize, this->chainMoves - chain.done);
+}
+
+bool Annealing::accept(Chain& chain, double delta) {
+    // better moves always go through, worse ones less and less often as the chain cools
+    return delta >= 0.0 || chain.chance(chain.random) < exp(delta / chain.temperature);
+}
+
+void Annealing::report(Chain& chain, int batch, double score) {
+    chain.done += batch;
+    chain.temperature *= chain.cooling;
+    this->movesDone += batch;
+
+    // filled up to how far along the chain is
+    int point = std::min<int64_t>(ANNEAL_CURVE, chain.done * ANNEAL_CURVE / std::max<int64_t>(1, this->chainMoves));
+    std::lock_guard<std::mutex> guard(this->lock);
+    for (int i = this->reached[chain.index]; i < point; i++) {
+        this->curves[chain.index * ANNEAL_CURVE + i] = score;
+    }
+    this->reached[chain.index] = std::max(this->reached[chain.index], point);
+}
+
+double Annealing::heat(Chain& chain) {
+    return chain.temperature / this->startTemperature;
+}
+
+int Annealing::chainCount() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->chains;
+}
+
+float Annealing::progress() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return (float) ((double) this->movesDone / this->totalMoves);
+}
+
+int Annealing::bestCurve(float* curve) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    int length = this->chains > 0 ? ANNEAL_CURVE : 0;
+    for (int chain = 0; chain < this->chains; chain++) {
+        length = std::min(length, this->reached[chain]);
+    }
+
+    for (int i = 0; i < length; i++) {
+        curve[i] = this->curves[i];
+        for (int chain = 1; chain < this->chains; chain++) {
+            curve[i] = std::max(curve[i], this->curves[chain * ANNEAL_CURVE + i]);
+        }
+    }
+
+    return length;
+}
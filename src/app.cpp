@@ -10,7 +10,14 @@
 #include "main.hpp"
 
 // constructor for main application
-App::App(CropRegistry* registry, std::ifstream* src) {
+App::App(CropRegistry* registry, std::string cropFile, std::vector<std::string> filenames) {
+    // used to show how long it took until the farm was first on screen
+    this->startTime = SDL_GetPerformanceCounter();
+    this->startupMs = 0.0f;
+
+    // allocation counting has to be hooked up before sdl or imgui allocate anything
+    AllocTracker::install();
+
     // setup sdl2 context
     // returns 0 on success, so should fail
     if (SDL_Init(SDL_INIT_EVERYTHING)) {
@@ -47,92 +54,336 @@ App::App(CropRegistry* registry, std::ifstream* src) {
 
     // setup class variables
     this->closed = false;
-    this->plots = std::vector<Plot*>();
     this->selectedPlot = nullptr;
     this->registry = registry;
-
-    // loading farm setup if there is no file found
-    if (src == nullptr) {
-        this->farmName = std::string("UNAMED FARM");
-        this->plotCount = 0;
-    } else {
-        // loading from a file, farm.json
-        Json::Reader reader;
-        Json::Value dst;
-        // read everything into dst as main object
-        reader.parse(*src, dst);
-
-        this->farmName = dst["name"].asString();
-        // size holds number of plots, size IS NOT the same as this->farmsize
-        int size = dst["size"].asInt();
-        Json::Value& plots = dst["plots"];
-
-        // load in every plot from the array
-        for (int i = 0; i < size; i++) {
-            // bounding box infomation
-            int x = plots[i]["x"].asInt();
-            int y = plots[i]["y"].asInt();
-            int w = plots[i]["width"].asInt();
-            int h = plots[i]["height"].asInt();
-
-            // plot/crop information
-            std::string name = plots[i]["name"].asString();
-            std::string crop = plots[i]["crop"].asString();
-            int cropIndex = plots[i]["cropIndex"].asInt();
-            double deviation = plots[i]["deviation"].asDouble();
-
-            // create new plot with data
-            CropRegistry::CropEntry* entry = this->registry->access(crop);
-            Plot* plot = new Plot(x, y, w, h, name, cropIndex, deviation, entry);
-            this->addNewPlot(plot);
-        }
+    this->autosaveDelay = AUTOSAVE_DEBOUNCE_MS;
+    this->memoryBudget = WORKSPACE_MEMORY_BUDGET_MB;
+    this->frameIndex = 0;
+    this->catalogRegion = -1;
+    this->catalogSeason = -1;
+    memset(this->frameTimes, 0, sizeof(this->frameTimes));
+    memset(this->frameAllocations, 0, sizeof(this->frameAllocations));
+    this->allocationWindowOpen = false;
+    this->hatchTexture = nullptr;
+    this->hatchSize = 0;
+    this->plotTable = new PlotTable();
+    this->minimap = new Minimap(this->renderer);
+    this->plotSearch = new PlotSearch();
+    this->heatmap = new Heatmap(this->renderer);
+    this->plantStore = new PlantStore();
+    this->plotWindows = new PlotWindows();
+    this->farmStats = new FarmStats();
+    this->simulation = new HarvestSimulation();
+    this->growth = new GrowthSimulation();
+    this->rotation = new RotationPlanner();
+    this->layout = new LayoutOptimizer();
+    memset(this->openPathBuffer, 0, sizeof(this->openPathBuffer));
+    memset(this->cropSearchBuffer, 0, sizeof(this->cropSearchBuffer));
+    this->cropSearch = new SearchQuery();
+
+    // crop edits show up without restarting
+    this->cropFile = cropFile;
+    this->cropWatcher = new CropWatcher(cropFile, registry);
+
+    // every farm given is listed, only the first is loaded
+    this->workspace = new Workspace(registry, (size_t) this->memoryBudget << 20, this->autosaveDelay);
+    for (auto& filename : filenames) {
+        this->workspace->add(filename);
     }
 
+    this->farm = this->workspace->open(filenames.front());
+    strncpy(this->farmNameBuffer, this->farm->name.c_str(), sizeof(this->farmNameBuffer) - 1);
+    this->farmNameBuffer[sizeof(this->farmNameBuffer) - 1] = '\0';
+
     // load assets
     this->loadAssets();
 }
 
-void App::saveFarm(std::string filename) {
-    // ignore saving if empty context
-    if (this->plotCount < 1) {
+// swapping farms is just a pointer change when the farm is still loaded
+void App::switchFarm(std::string filename) {
+    if (filename == this->farm->filename) {
         return;
     }
 
-    // main object to be serialized
-    Json::Value farmData;
-    farmData["name"] = this->farmName;
-    farmData["size"] = this->plotCount;
+    // anything changed so far still goes to the old farm's autosave
+    this->farm->submitChanges();
 
-    // json array holding objects which are the actual plots
-    Json::Value plots(Json::arrayValue);
+    this->selectedPlot = nullptr;
+    this->farm = this->workspace->open(filename);
+    this->plotTable->reset();
+    this->minimap->reset();
+    this->plotSearch->reset();
+    this->heatmap->reset();
+    this->plantStore->reset();
+    this->plotWindows->clear();
+    this->farmStats->reset();
+    this->growth->reset();
+    this->rotation->reset();
+    this->layout->reset();
+    strncpy(this->farmNameBuffer, this->farm->name.c_str(), sizeof(this->farmNameBuffer) - 1);
+    this->farmNameBuffer[sizeof(this->farmNameBuffer) - 1] = '\0';
+}
+
+// list of farms, with loaded ones marked
+void App::showWorkspace() {
+    for (auto& filename : this->workspace->files) {
+        bool active = filename == this->farm->filename;
 
-    for (auto& plot : this->plots) {
-        Json::Value plotData;
+        // the label is built on the stack, this runs every frame
+        char label[300];
+        snprintf(label, sizeof(label), "%s%s", filename.c_str(), this->workspace->isResident(filename) ? "" : " (unloaded)");
 
-        // serialize all the data
-        plotData["name"] = plot->plotName;
-        plotData["x"] = plot->bounds.x;
-        plotData["y"] = plot->bounds.y;
-        plotData["width"] = plot->bounds.w;
-        plotData["height"] = plot->bounds.h;
-        plotData["crop"] = plot->cropName;
-        plotData["cropIndex"] = plot->cropIndex;
-        plotData["deviation"] = plot->yieldDeviance;
+        if (ImGui::Selectable(label, active) && !active) {
+            this->switchFarm(filename);
+        }
+    }
 
-        // add to list
-        plots.append(plotData);
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+    ImGui::InputText("##openpath", this->openPathBuffer, sizeof(this->openPathBuffer));
+    ImGui::SameLine();
+    if (ImGui::Button("Open Farm") && this->openPathBuffer[0] != '\0') {
+        this->switchFarm(std::string(this->openPathBuffer));
+        memset(this->openPathBuffer, 0, sizeof(this->openPathBuffer));
     }
 
-    // asign list as a field
-    farmData["plots"] = plots;
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+    if (ImGui::SliderInt("Memory Budget", &this->memoryBudget, 16, 4096, "%d MB")) {
+        this->workspace->setMemoryBudget((size_t) this->memoryBudget << 20);
+    }
 
-    // serialize
-    std::ofstream file(filename);
-    file << farmData;
-    file.close();
+    ImGui::Text("Loaded: %.1f MB", this->workspace->memoryUse() / (1024.0 * 1024.0));
+}
+
+// region and season used for catalog yields, -1 shows the average over all of them
+void App::showCatalog() {
+    CropCatalog& catalog = this->registry->catalog;
+    ImGui::Text("Catalog: %d rows from %d files", catalog.rows(), (int) catalog.sources.size());
+
+    // code 0 is rows that didnt give a region or season, shown as unspecified
+    auto picker = [&](const char* label, CropCatalog::Dictionary& dictionary, int* code) {
+        const char* preview = *code < 0 ? "Any" : (*code == 0 ? "Unspecified" : dictionary.values[*code].c_str());
+
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+        if (ImGui::BeginCombo(label, preview)) {
+            if (ImGui::Selectable("Any", *code < 0)) {
+                *code = -1;
+            }
+            for (int i = 0; i < (int) dictionary.values.size(); i++) {
+                if (ImGui::Selectable(i == 0 ? "Unspecified" : dictionary.values[i].c_str(), *code == i)) {
+                    *code = i;
+                }
+            }
+            ImGui::EndCombo();
+        }
+    };
+
+    picker("Region", catalog.regions, &this->catalogRegion);
+    picker("Season", catalog.seasons, &this->catalogSeason);
+}
+
+// crop list with a search box, only the visible rows of the results are drawn
+void App::showCropPicker(int* selection) {
+    std::vector<CropRegistry::CropEntry*>& ordered = this->registry->ordered;
+
+    if (ImGui::BeginCombo("Crop", ordered[*selection]->name.c_str(), ImGuiComboFlags_HeightLarge)) {
+        // the search starts over every time the list is opened
+        if (ImGui::IsWindowAppearing()) {
+            this->cropSearchBuffer[0] = '\0';
+            ImGui::SetKeyboardFocusHere();
+        }
+
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        bool entered = ImGui::InputTextWithHint("##cropsearch", "Search crops", this->cropSearchBuffer, sizeof(this->cropSearchBuffer), ImGuiInputTextFlags_EnterReturnsTrue);
+        this->registry->search.update(this->cropSearch, this->cropSearchBuffer);
+        std::vector<int>& results = this->cropSearch->results;
+
+        // enter picks the top result
+        if (entered && !results.empty()) {
+            *selection = results[0];
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGuiListClipper clipper;
+        clipper.Begin(results.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                int index = results[i];
+                ImGui::PushID(index);
+                if (ImGui::Selectable(ordered[index]->name.c_str(), index == *selection)) {
+                    *selection = index;
+                }
+                ImGui::PopID();
+            }
+        }
+
+        ImGui::EndCombo();
+    }
+}
+
+// every plot is one row, or PLOT_TREE_ROWS rows when expanded
+// rows are numbered so the clipper can jump straight to the first visible one
+void App::showContents() {
+    std::vector<Plot*>& plots = this->farm->plots;
+    std::vector<int>& expanded = this->farm->expandedPlots;
+
+    // row a plot's name is on, every expanded plot before it pushes it down
+    auto rowOf = [&](int id) {
+        return id + (PLOT_TREE_ROWS - 1) * (int) (std::lower_bound(expanded.begin(), expanded.end(), id) - expanded.begin());
+    };
+
+    // toggles are applied after the list is drawn, they change the row numbers
+    int toggled = -1;
+
+    // using table for a list of treenodes
+    // so no top level treenode
+    ImGui::BeginTable("table", 1);
+    {
+        ImGuiListClipper clipper;
+        clipper.Begin(plots.size() + (PLOT_TREE_ROWS - 1) * expanded.size());
+
+        while (clipper.Step()) {
+            // last plot starting at or before the first visible row
+            int low = 0;
+            int high = (int) plots.size() - 1;
+            while (low < high) {
+                int middle = (low + high + 1) / 2;
+                if (rowOf(middle) <= clipper.DisplayStart) {
+                    low = middle;
+                } else {
+                    high = middle - 1;
+                }
+            }
+
+            int id = low;
+            int line = clipper.DisplayStart - rowOf(id);
+
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd && id < (int) plots.size(); row++) {
+                Plot* p = plots[id];
+                bool open = std::binary_search(expanded.begin(), expanded.end(), id);
+
+                // next column must be called as well
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID(id);
+
+                if (line == 0) {
+                    // the open state is kept by the farm, so plots scrolled out of view keep theirs
+                    // names might still be loading in the background
+                    ImGui::SetNextItemOpen(open);
+                    bool clicked = ImGui::TreeNodeEx("##plot", ImGuiTreeNodeFlags_NoTreePushOnOpen, "%s", p->hasDetails() ? p->plotName : "Loading...");
+                    if (clicked != open) {
+                        toggled = id;
+                    }
+
+                    // right clicking opens the plot's config window
+                    if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
+                        this->plotWindows->toggle(p);
+                    }
+                // display extra information about plot
+                } else if (line == 1) {
+                    ImGui::TreeNodeEx("##crop", ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen, "Crop: %s", p->cropName.c_str());
+                } else if (line == 2) {
+                    ImGui::TreeNodeEx("##position", ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen, "Position: (%d, %d)", p->bounds.x, p->bounds.y);
+                } else {
+                    ImGui::TreeNodeEx("##size", ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen, "Size: (%d, %d)", p->bounds.w, p->bounds.h);
+                }
+
+                ImGui::PopID();
+
+                // move on to the next plot once this one's rows are done
+                line++;
+                if (line >= (open ? PLOT_TREE_ROWS : 1)) {
+                    line = 0;
+                    id++;
+                }
+            }
+        }
+    }
+
+    ImGui::EndTable();
+
+    if (toggled >= 0) {
+        auto at = std::lower_bound(expanded.begin(), expanded.end(), toggled);
+        if (at != expanded.end() && *at == toggled) {
+            expanded.erase(at);
+        } else {
+            expanded.insert(at, toggled);
+        }
+    }
+}
+
+// frame time graph and autosave numbers
+void App::showPerformance() {
+    float total = 0.0f;
+    float worst = 0.0f;
+    for (int i = 0; i < FRAME_HISTORY; i++) {
+        total += this->frameTimes[i];
+        worst = std::max(worst, this->frameTimes[i]);
+    }
+
+    ImGui::Text("Frame: %.2f ms avg, %.2f ms max", total / FRAME_HISTORY, worst);
+    ImGui::Text("Startup: %.1f ms to the first frame", this->startupMs);
+    if (this->farm->detailLoader && !this->farm->detailLoader->done()) {
+        ImGui::Text("Loading plot details...");
+    }
+
+    ImGui::PlotLines("##frametimes", this->frameTimes, FRAME_HISTORY, this->frameIndex, nullptr, 0.0f, 20.0f, ImVec2(ImGui::GetContentRegionAvail().x, 40));
+    ImGui::Text("Autosaves: %d (last took %.1f ms)", this->farm->autosave->writeCount.load(), this->farm->autosave->lastWriteMs.load());
+
+    if (AllocTracker::enabled()) {
+        int last = (this->frameIndex + FRAME_HISTORY - 1) % FRAME_HISTORY;
+        ImGui::Text("Allocations: %d last frame", (int) this->frameAllocations[last]);
+        ImGui::SameLine();
+        ImGui::Checkbox("Details##allocations", &this->allocationWindowOpen);
+    }
+}
+
+// debug window for chasing down allocations, a frame that only redraws or drags should make none
+void App::showAllocations() {
+    ImGui::SetNextWindowSize(ImVec2(360, 200), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Allocations", &this->allocationWindowOpen)) {
+        float total = 0.0f;
+        float worst = 0.0f;
+        int clean = 0;
+        for (int i = 0; i < FRAME_HISTORY; i++) {
+            total += this->frameAllocations[i];
+            worst = std::max(worst, this->frameAllocations[i]);
+            clean += this->frameAllocations[i] == 0.0f;
+        }
+
+        ImGui::Text("Per frame: %.1f avg, %d max", total / FRAME_HISTORY, (int) worst);
+        ImGui::Text("Frames with none: %d of %d", clean, FRAME_HISTORY);
+
+        // totals for the main thread since startup, by who asked for the memory
+        AllocTracker::Counts counts = AllocTracker::current();
+        ImGui::Text("new: %llu  imgui: %llu  sdl: %llu", (unsigned long long) counts.news, (unsigned long long) counts.imgui, (unsigned long long) counts.sdl);
+        ImGui::Text("Allocated: %.1f MB", counts.bytes / (1024.0 * 1024.0));
+
+        ImGui::PlotHistogram("##allocations", this->frameAllocations, FRAME_HISTORY, this->frameIndex, nullptr, 0.0f, std::max(worst, 1.0f), ImVec2(ImGui::GetContentRegionAvail().x, 60));
+    }
+    ImGui::End();
 }
 
 App::~App() {
+    // closing every farm writes out any changes still waiting
+    delete this->workspace;
+    delete this->cropWatcher;
+    delete this->cropSearch;
+    delete this->plotTable;
+    delete this->minimap;
+    delete this->plotSearch;
+    delete this->heatmap;
+    delete this->plantStore;
+    delete this->plotWindows;
+    delete this->farmStats;
+    delete this->simulation;
+    delete this->growth;
+    delete this->rotation;
+    delete this->layout;
+    if (this->hatchTexture) {
+        SDL_DestroyTexture(this->hatchTexture);
+    }
+
     // shutdown IMGUI
     ImGui_ImplSDLRenderer2_Shutdown();
     ImGui_ImplSDL2_Shutdown();
@@ -147,6 +398,9 @@ App::~App() {
 int App::run() {
     // main loop, the application lives out of this function
     while (!this->closed) {
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        AllocTracker::Counts allocStart = AllocTracker::current();
+
         // update not only has the application logic, but also all the GUI rendering code
         // why? its just how imgui works. all the gui calls have to be done in update
         this->update();
@@ -162,7 +416,19 @@ int App::run() {
         //SDL_RenderSetScale(renderer, io.DisplayFramebufferScale.x, io.DisplayFramebufferScale.y);
         ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), renderer);
 
+        // time spent on our own work, presenting is left out since it waits on vsync
+        Uint64 frameEnd = SDL_GetPerformanceCounter();
+        this->frameTimes[this->frameIndex] = (float) (frameEnd - frameStart) * 1000.0f / SDL_GetPerformanceFrequency();
+
         SDL_RenderPresent(renderer);
+
+        // counted after presenting, anything the driver allocates counts against the frame too
+        this->frameAllocations[this->frameIndex] = (float) AllocTracker::since(allocStart).total();
+        this->frameIndex = (this->frameIndex + 1) % FRAME_HISTORY;
+
+        if (this->startupMs == 0.0f) {
+            this->startupMs = (float) (SDL_GetPerformanceCounter() - this->startTime) * 1000.0f / SDL_GetPerformanceFrequency();
+        }
     }
 
     return 0;
@@ -179,6 +445,15 @@ void App::update() {
     this->deltaMouse.x = this->mouse.x - lastmouse.x;
     this->deltaMouse.y = this->mouse.y - lastmouse.y;
 
+    // farm housekeeping, like starting the autosave once loading finishes
+    this->farm->update();
+
+    // pick up crop file reloads, the farm being edited is updated right away and others when they are drawn
+    CropReload cropReload;
+    if (this->cropWatcher->poll(&cropReload)) {
+        this->registry->applyChanges(cropReload, this->farm);
+    }
+
     // processing the sdl events
     while (SDL_PollEvent(&event)) {
         // important! pass to imgui first
@@ -188,18 +463,36 @@ void App::update() {
             this->closed = true;
         }
 
+        // render target contents can be lost when the device resets, the hatching is drawn again
+        else if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+            this->hatchSize = 0;
+            this->minimap->invalidate();
+            this->heatmap->invalidate();
+        }
+
+        // undo and redo shortcuts, left alone while typing into a text field
+        else if (event.type == SDL_KEYDOWN && (event.key.keysym.mod & KMOD_CTRL) && !ImGui::GetIO().WantTextInput) {
+            bool shift = event.key.keysym.mod & KMOD_SHIFT;
+            if (event.key.keysym.sym == SDLK_z && !shift) {
+                this->farm->history.undo(this->farm);
+            } else if (event.key.keysym.sym == SDLK_y || (event.key.keysym.sym == SDLK_z && shift)) {
+                this->farm->history.redo(this->farm);
+            }
+        }
+
         // testing for right click
         else if (event.type == SDL_MOUSEBUTTONUP) {
+            // letting go of left click ends a drag, so the next one is its own undo step
+            if (event.button.button == SDL_BUTTON_LEFT) {
+                this->farm->history.seal();
+            }
+
             if (event.button.button == SDL_BUTTON_RIGHT) {
-                for (auto& plot : this->plots) {
-                    // if one of the plots was clicked
+                for (auto& plot : this->farm->plots) {
+                    // if one of the plots was clicked, plots never overlap so nothing else can have been
                     if (plot->registerClick(&this->mouse)) {
-                        // we close all other windows save for the one that just opened
-                        for (auto& ptmp : this->plots) {
-                            if (ptmp != plot) {
-                                ptmp->windowOpen = false;
-                            }
-                        }
+                        this->plotWindows->toggle(plot);
+                        break;
                     }
                 }
             }
@@ -211,9 +504,6 @@ void App::update() {
     ImGui_ImplSDL2_NewFrame();
     ImGui::NewFrame();
 
-    char outlineNameBuffer[128] = {};
-    strcpy(outlineNameBuffer, this->farmName.c_str());
-
     // the side window with all the baseline information
     ImGui::SetNextWindowPos(ImVec2(0, 0));
     ImGui::SetNextWindowSize(ImVec2(WINDOW_WIDTH * SIDE_PANEL_WIDTH, WINDOW_HEIGHT));
@@ -222,71 +512,94 @@ void App::update() {
         ImGui::SeparatorText("Farm Properties");
 
         ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
-        ImGui::InputText("Farm Name", outlineNameBuffer, 128);
-        this->farmName = std::string(outlineNameBuffer);
+        if (ImGui::InputText("Farm Name", this->farmNameBuffer, sizeof(this->farmNameBuffer))) {
+            this->farm->name = this->farmNameBuffer;
+            this->farm->nameDirty = true;
+        }
 
         if (ImGui::Button("Save To Disk")) {
-            this->saveFarm("farm.json");
+            this->farm->save(this->farm->filename);
+        }
+
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!this->farm->history.canUndo());
+        if (ImGui::Button("Undo")) {
+            this->farm->history.undo(this->farm);
+        }
+        ImGui::EndDisabled();
+
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!this->farm->history.canRedo());
+        if (ImGui::Button("Redo")) {
+            this->farm->history.redo(this->farm);
+        }
+        ImGui::EndDisabled();
+
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+        if (ImGui::SliderInt("Autosave Delay", &this->autosaveDelay, 250, 10000, "%d ms")) {
+            this->workspace->setAutosaveDelay(this->autosaveDelay);
         }
 
         ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.4);
-        ImGui::Text("Crop Data Source: %s", "crop.csv");
+        ImGui::Text("Crop Data Source: %s", this->cropFile.c_str());
 
-        ImGui::SeparatorText("Farm Contents");
-        ImGui::Text("Total Plots: %d", this->plotCount);
+        ImGui::SeparatorText("Workspace");
+        this->showWorkspace();
 
-        // for treenodes to work, they need unique id's
-        // so this counter and the following lambda make new id's everytime its called
-        int nodeCounter = 0;
-        auto fakeid = [&]() { return std::string("node" + std::to_string(nodeCounter++)).c_str(); };
+        ImGui::SeparatorText("Yield Summary");
+        this->farmStats->show(this->farm, this->registry);
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Simulate")) {
+            this->simulation->open = !this->simulation->open;
+        }
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Season")) {
+            this->growth->open = !this->growth->open;
+        }
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Rotation")) {
+            this->rotation->open = !this->rotation->open;
+        }
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Layout")) {
+            this->layout->open = !this->layout->open;
+        }
 
-        ImGui::BeginChild("content_tree");
-        {
-            // using table for a list of treenodes
-            // so no top level treenode
-            ImGui::BeginTable("table", 1);
-            {
-                for (auto& p : this->plots) {
-                    // next column must be called as well
-                    ImGui::TableNextRow();
-                    ImGui::TableNextColumn();
+        ImGui::SeparatorText("Heatmap");
+        this->heatmap->show();
 
+        ImGui::SeparatorText("Plants");
+        this->plantStore->show(this->farm, this->registry);
 
-                    // the treenode status is saved in a variable instead of being consumed directly
-                    auto open = ImGui::TreeNode(fakeid(), "%s", p->plotName);
+        if (this->registry->catalog.rows() > 0) {
+            ImGui::SeparatorText("Crop Catalog");
+            this->showCatalog();
+        }
 
-                    // this way we can test if its been clicked, and also test if its open later
-                    if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
-                        p->windowOpen = !p->windowOpen;
-                        for (auto& ptmp : this->plots) {
-                            if (ptmp != p) {
-                                ptmp->windowOpen = false;
-                            }
-                        }
-                    }
+        ImGui::SeparatorText("Minimap");
+        this->minimap->show(this->farm, this->registry, this->plotWindows);
 
-                    ImGui::Unindent();
-
-                    // display extra information about plot
-                    if (open) {
-                        ImGui::TreeNodeEx(fakeid(), ImGuiTreeNodeFlags_Leaf, "Crop: %s", p->cropName.c_str());
-                        ImGui::TreePop();
-                        ImGui::TreeNodeEx(fakeid(), ImGuiTreeNodeFlags_Leaf, "Position: (%d, %d)", p->bounds.x, p->bounds.y);
-                        ImGui::TreePop();
-                        ImGui::TreeNodeEx(fakeid(), ImGuiTreeNodeFlags_Leaf, "Size: (%d, %d)", p->bounds.w, p->bounds.h);
-                        ImGui::TreePop();
-                        ImGui::TreePop();
-                    }
+        ImGui::SeparatorText("Performance");
+        this->showPerformance();
 
-                    ImGui::Indent();
-                }
-            }
+        ImGui::SeparatorText("Find Plot");
+        this->plotSearch->show(this->farm, this->registry, this->plotWindows);
 
-            ImGui::EndTable();
+        ImGui::SeparatorText("Farm Contents");
+        ImGui::Text("Total Plots: %d", (int) this->farm->plots.size());
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Plot Table")) {
+            this->plotTable->open = !this->plotTable->open;
+        }
+
+        ImGui::BeginChild("content_tree");
+        {
+            this->showContents();
 
             if (ImGui::Button("New Plot")) {
                 Plot* newPlot = new Plot(500, 500, 50, 50, "UNAMED PLOT", 0, 0.0, this->registry->access("NO SELECTION"));
-                this->addNewPlot(newPlot);
+                this->farm->addPlot(newPlot);
+                this->farm->markDirty(newPlot);
             }
         }
 
@@ -295,72 +608,147 @@ void App::update() {
 
     ImGui::End();
 
+    if (this->allocationWindowOpen) {
+        this->showAllocations();
+    }
+
+    if (this->simulation->open) {
+        this->simulation->show(this->farm, this->registry);
+    }
+
+    if (this->growth->open) {
+        this->growth->show(this->farm);
+    }
+
+    if (this->rotation->open) {
+        this->rotation->show(this->farm, this->registry);
+    }
+
+    if (this->layout->open) {
+        this->layout->show(this->farm, this->registry);
+    }
+
+    if (this->plotTable->open) {
+        this->plotTable->show(this->farm, this->registry, this->plotWindows);
+    }
+
     // state variable to determine if a click was made inside the gui or the app 
     bool passInputs = true;
 
-    // imgui combo boxes need all the options in char* format not std::string
-    // so the first array is an array of char*
-    // the second is a vector of std::string
-    char** cropOptions = this->registry->getKeyListAsCSTRS();
-    std::vector<std::string> keyList = this->registry->getKeyList();
-    int optionCount = keyList.size();
-
-    for (auto& plot : this->plots) {
-        // if the plot has its config window open
-        if (plot->windowOpen) {
-            // fields that will be pointed to by inputs
-            // important that plot fields are not modified directly
-            int inputXCoord = plot->bounds.x;
-            int inputYCoord = plot->bounds.y;
-            int inputWidth = plot->bounds.w;
-            int inputHeight = plot->bounds.h;
-            int selection = plot->cropIndex;
-        
-            ImGui::SetNextWindowSize(ImVec2(320, 270));
-            ImGui::Begin("Plot Configuration", &plot->windowOpen, ImGuiWindowFlags_NoResize);
-            {
-                ImGui::SeparatorText("Properties");
-                ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
-                ImGui::InputText("Plot Name", plot->plotName, sizeof(plot->plotName));
-                ImGui::InputInt("Position X", &inputXCoord, 10);
-                ImGui::InputInt("Position Y", &inputYCoord, 10);
-                ImGui::InputInt("Width", &inputWidth, 10);
-                ImGui::InputInt("Height", &inputHeight, 10);
-
-                ImGui::SeparatorText("Crop Information");
-                ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
-
-                // dont display any extra crop info if no crop selected
-                if (selection == 0) {
-                    ImGui::Combo("Crop", &selection, cropOptions, optionCount);
-                } else {
-                    ImGui::Combo("Crop", &selection, cropOptions, optionCount);
-                    ImGui::InputFloat("Expected Yield", &plot->expectedYield, 0.0, 0.0, "%.1f lbs/plant");
-                    ImGui::DragFloat("Yield Deviance", &plot->yieldDeviance, 0.1, 0.0, 100.0, "%.1f%%");
+    // only the plots with a window open are walked, not the whole farm
+    std::vector<PlotWindows::Window>& windows = this->plotWindows->windows;
+    for (int i = 0; i < (int) windows.size(); i++) {
+        Plot* plot = windows[i].plot;
+        bool open = true;
+
+        // the window needs the name and deviation right now
+        this->farm->requireDetails(plot);
+
+        // fields that will be pointed to by inputs
+        // important that plot fields are not modified directly
+        int inputXCoord = plot->bounds.x;
+        int inputYCoord = plot->bounds.y;
+        int inputWidth = plot->bounds.w;
+        int inputHeight = plot->bounds.h;
+        int selection = plot->crop->index;
+        SDL_Rect before = plot->bounds;
+        bool changed = false;
+
+        // previous values, kept for the undo history
+        char nameBefore[sizeof(plot->plotName)];
+        memcpy(nameBefore, plot->plotName, sizeof(nameBefore));
+        float deviationBefore = plot->yieldDeviance;
+    
+        // several can be open at once, so each gets its own id
+        char title[64];
+        snprintf(title, sizeof(title), "Plot Configuration##%d", plot->id);
+
+        // pinned windows are staggered the first time they show up, so they dont all land on top of each other
+        ImGui::SetNextWindowPos(ImVec2(WINDOW_WIDTH * SIDE_PANEL_WIDTH + 40 + i * 24, 40 + i * 24), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(320, this->registry->catalog.rows() > 0 ? 290 : 270));
+        ImGui::Begin(title, &open, ImGuiWindowFlags_NoResize);
+        {
+            ImGui::SeparatorText("Properties");
+            ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+            if (ImGui::InputText("Plot Name", plot->plotName, sizeof(plot->plotName))) {
+                this->farm->history.recordName(plot, nameBefore, plot->plotName);
+                changed = true;
+            }
+
+            // done typing, the next rename is its own undo step
+            if (ImGui::IsItemDeactivated()) {
+                this->farm->history.seal();
+            }
+            ImGui::InputInt("Position X", &inputXCoord, 10);
+            ImGui::InputInt("Position Y", &inputYCoord, 10);
+            ImGui::InputInt("Width", &inputWidth, 10);
+            ImGui::InputInt("Height", &inputHeight, 10);
+
+            ImGui::SeparatorText("Crop Information");
+            ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+
+            // dont display any extra crop info if no crop selected
+            if (selection == 0) {
+                this->showCropPicker(&selection);
+            } else {
+                this->showCropPicker(&selection);
+                if (ImGui::InputFloat("Expected Yield", &plot->expectedYield, 0.0, 0.0, "%.1f lbs/plant")) {
+                    changed = true;
                 }
 
-                ImGui::SeparatorText("Actions");
+                // finer grained figure for the region and season picked in the side panel
+                CropCatalog& catalog = this->registry->catalog;
+                if (catalog.rows() > 0) {
+                    int matched = 0;
+                    double catalogYield = catalog.averageYield(catalog.crops.find(plot->cropName), this->catalogRegion, this->catalogSeason, &matched);
+                    if (matched > 0) {
+                        ImGui::Text("Catalog Yield: %.1f lbs/plant (%d rows)", catalogYield, matched);
+                    } else {
+                        ImGui::Text("Catalog Yield: no rows");
+                    }
+                }
+                if (ImGui::DragFloat("Yield Deviance", &plot->yieldDeviance, 0.1, 0.0, 100.0, "%.1f%%")) {
+                    this->farm->history.recordDeviation(plot, deviationBefore, plot->yieldDeviance);
+                    changed = true;
+                }
 
-                if (ImGui::IsWindowHovered()) {
-                    passInputs = false;
+                if (ImGui::IsItemDeactivated()) {
+                    this->farm->history.seal();
                 }
             }
 
-            ImGui::End();
+            ImGui::SeparatorText("Actions");
+            ImGui::Checkbox("Pin Window", &windows[i].pinned);
 
-            // if the crop name is different than update the crop information
-            if (plot->cropName.compare(cropOptions[selection])) {
-                CropRegistry::CropEntry* entry = this->registry->access(keyList.at(selection));
-                plot->updateProperties(entry, selection);
+            if (ImGui::IsWindowHovered()) {
+                passInputs = false;
             }
+        }
 
-            // more updating
-            plot->updateFromInputs(inputXCoord, inputYCoord, inputWidth, inputHeight, this->plots);
+        ImGui::End();
+
+        // if the crop name is different than update the crop information
+        if (selection != plot->crop->index) {
+            CropRegistry::CropEntry* previous = plot->crop;
+            CropRegistry::CropEntry* entry = this->registry->ordered[selection];
+            this->farm->history.recordCrop(plot, previous, plot->cropIndex, entry, selection);
+            plot->updateProperties(entry, selection);
+            changed = true;
         }
-    }
 
-    // free all the memory allocated for the char* array
-    this->registry->freeCSTRS(cropOptions, optionCount);
+        // more updating
+        plot->updateFromInputs(inputXCoord, inputYCoord, inputWidth, inputHeight, this->farm->plots);
+        this->farm->history.recordRect(plot, before, plot->bounds, false);
+
+        if (changed || !SDL_RectEquals(&before, &plot->bounds)) {
+            this->farm->markDirty(plot);
+        }
+
+        if (!open) {
+            windows.erase(windows.begin() + i);
+            i--;
+        }
+    }
 
     // render all widgets
     ImGui::Render();
@@ -369,7 +757,7 @@ void App::update() {
     if (passInputs) {
         // updating when no plot selection
         if (this->selectedPlot == nullptr) {
-            for (auto plot : this->plots) {
+            for (auto plot : this->farm->plots) {
                 // call update for each plot to find out if its been selected
                 bool isSelected = plot->update();
                 if (isSelected) {
@@ -383,7 +771,7 @@ void App::update() {
         // updating when plot selected : ignore all others
         else {
             // special update for when certain things dont need to be updated
-            for (auto plot : this->plots) {
+            for (auto plot : this->farm->plots) {
                 plot->updateNonSelected(false);
             }
 
@@ -398,23 +786,28 @@ void App::update() {
 
         // if we still have a selected plot, move it based on delatMouse
         if (this->selectedPlot && this->selectedPlot->isSelected()) {
-            this->selectedPlot->updatePosition(&this->deltaMouse, this->plots);
+            SDL_Rect before = this->selectedPlot->bounds;
+            this->selectedPlot->updatePosition(&this->deltaMouse, this->farm->plots);
+
+            // the whole drag becomes one undo step
+            this->farm->history.recordRect(this->selectedPlot, before, this->selectedPlot->bounds, true);
+
+            if (!SDL_RectEquals(&before, &this->selectedPlot->bounds)) {
+                this->farm->markDirty(this->selectedPlot);
+            }
         }
     } else {
         this->selectedPlot = nullptr;
-        for (auto plot : this->plots) {
+        for (auto plot : this->farm->plots) {
             plot->updateNonSelected(true);
         }
     }
 
     // update the cursor icon based on whats happening in updates
     this->updateCursor();
-}
 
-// adds a new plot to list and manages the plot count
-void App::addNewPlot(Plot* plot) {
-    this->plots.push_back(plot);
-    this->plotCount = this->plots.size();
+    // hand this frame's changes to the autosave
+    this->farm->submitChanges();
 }
 
 // set the cursor to appropriate pointer
@@ -433,9 +826,75 @@ void App::updateCursor() {
 
 // render all the plots in the scene
 void App::renderEngine() {
-    for (auto plot : this->plots) {
-        plot->render(this->renderer);
+    // the hatching has to cover the biggest plot, it only gets redrawn when a plot outgrows it
+    int largest = 1;
+    for (auto plot : this->farm->plots) {
+        largest = std::max(largest, std::max(plot->bounds.w, plot->bounds.h));
+    }
+
+    if (largest > this->hatchSize) {
+        this->buildHatch(largest);
     }
+
+    for (auto plot : this->farm->plots) {
+        plot->render(this->renderer, this->hatchTexture);
+    }
+
+    // yield or risk shading over the crop colors
+    if (this->heatmap->open) {
+        this->heatmap->render(this->farm, this->registry);
+    }
+
+    // a dot for every plant, dead ones stand out from the live ones
+    if (this->plantStore->open) {
+        this->plantStore->render(this->renderer, this->farm, this->registry);
+    }
+
+    // stages from the growth timeline, only while its window is open
+    if (this->growth->open) {
+        this->growth->render(this->renderer, this->farm);
+    }
+
+    // field and obstacles the layout optimizer works with
+    if (this->layout->open) {
+        this->layout->render(this->renderer);
+    }
+
+    // plots matching the search are outlined on top, just inside their border
+    SDL_SetRenderDrawColor(this->renderer, 0xF0, 0xD0, 0x20, 0xFF);
+    for (int id : this->plotSearch->matches()) {
+        SDL_Rect bounds = this->farm->plots[id]->bounds;
+        SDL_Rect outline = {bounds.x + 1, bounds.y + 1, bounds.w - 2, bounds.h - 2};
+        SDL_RenderDrawRect(this->renderer, &outline);
+    }
+}
+
+// draws white diagonal lines every PLOT_LINE_SPACING pixels, plots tint it with their color
+void App::buildHatch(int size) {
+    // some headroom so resizing a plot a little doesnt rebuild it again
+    size = std::max(size + size / 2, 256);
+
+    if (this->hatchTexture == nullptr || size > this->hatchSize) {
+        if (this->hatchTexture) {
+            SDL_DestroyTexture(this->hatchTexture);
+        }
+
+        this->hatchTexture = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, size, size);
+        SDL_SetTextureBlendMode(this->hatchTexture, SDL_BLENDMODE_BLEND);
+        this->hatchSize = size;
+    }
+
+    SDL_SetRenderTarget(this->renderer, this->hatchTexture);
+    SDL_SetRenderDrawColor(this->renderer, 0, 0, 0, 0);
+    SDL_RenderClear(this->renderer);
+
+    // same lines the plots used to draw for themselves
+    SDL_SetRenderDrawColor(this->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    for (int i = 0; i <= (this->hatchSize / PLOT_LINE_SPACING) * 2; i++) {
+        SDL_RenderDrawLine(this->renderer, 0, i * PLOT_LINE_SPACING, i * PLOT_LINE_SPACING, 0);
+    }
+
+    SDL_SetRenderTarget(this->renderer, NULL);
 }
 
 // loads all the sdl cursors
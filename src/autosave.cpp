@@ -0,0 +1,175 @@
+/*
+ *  autosave.cpp - debounced background saving of farm changes
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// starts the worker, which sleeps until it is seeded and something changes
+Autosave::Autosave(std::string filename, int debounceMs) {
+    this->filename = filename;
+    this->debounceMs = debounceMs;
+    this->stopping = false;
+    this->seeded = false;
+    this->nameChanged = false;
+    this->flushRequested = 0;
+    this->flushWritten = 0;
+    this->flushGood = false;
+    this->discarded = false;
+    this->writeCount = 0;
+    this->lastWriteMs = 0.0f;
+
+    this->worker = std::thread(&Autosave::run, this);
+}
+
+// the worker writes whatever is still pending before it exits
+Autosave::~Autosave() {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stopping = true;
+    }
+
+    this->wake.notify_one();
+    this->worker.join();
+}
+
+void Autosave::seed(std::string farmName, std::vector<PlotRecord>& records) {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->pendingName = farmName;
+        this->seedRecords = records;
+        this->seeded = true;
+    }
+
+    this->wake.notify_one();
+}
+
+void Autosave::submit(std::vector<PlotRecord>& records) {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        for (auto& record : records) {
+            this->pending[record.id] = record;
+        }
+
+        this->lastChange = std::chrono::steady_clock::now();
+    }
+
+    this->wake.notify_one();
+}
+
+void Autosave::submitName(std::string name) {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->pendingName = name;
+        this->nameChanged = true;
+        this->lastChange = std::chrono::steady_clock::now();
+    }
+
+    this->wake.notify_one();
+}
+
+void Autosave::setDebounce(int ms) {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->debounceMs = ms;
+    }
+
+    this->wake.notify_one();
+}
+
+// manual saves go through the worker too, so two writes of the same file never overlap
+bool Autosave::flush() {
+    std::unique_lock<std::mutex> guard(this->lock);
+    if (!this->seeded || this->discarded) {
+        return false;
+    }
+
+    int request = ++this->flushRequested;
+    this->wake.notify_one();
+    this->flushed.wait(guard, [&] { return this->flushWritten >= request; });
+
+    return this->flushGood;
+}
+
+void Autosave::discard() {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->discarded = true;
+        this->pending.clear();
+        this->nameChanged = false;
+    }
+
+    this->wake.notify_one();
+}
+
+void Autosave::run() {
+    std::unique_lock<std::mutex> guard(this->lock);
+    bool hasSeed = false;
+
+    while (true) {
+        // take over the full farm once it has been handed to us
+        if (this->seeded && !hasSeed) {
+            this->mirror.swap(this->seedRecords);
+            this->farmName = this->pendingName;
+            hasSeed = true;
+        }
+
+        bool flushing = this->flushRequested > this->flushWritten;
+        bool hasChanges = !this->pending.empty() || this->nameChanged || flushing;
+
+        // nothing to do, sleep until something changes
+        // an idle farm never touches the disk, and neither does a discarded one
+        if (this->discarded) {
+            this->pending.clear();
+            hasChanges = false;
+        }
+        if (!hasSeed || !hasChanges) {
+            if (this->stopping) {
+                break;
+            }
+
+            this->wake.wait(guard);
+            continue;
+        }
+
+        // wait until the farm has been left alone long enough, unless we are shutting down
+        auto due = this->lastChange + std::chrono::milliseconds(this->debounceMs);
+        if (!this->stopping && !flushing && std::chrono::steady_clock::now() < due) {
+            this->wake.wait_until(guard, due);
+            continue;
+        }
+
+        // move the pending changes into our copy, this is the only part the main thread can wait on
+        for (auto& pair : this->pending) {
+            if (pair.first >= (int) this->mirror.size()) {
+                this->mirror.resize(pair.first + 1);
+            }
+
+            this->mirror[pair.first] = pair.second;
+        }
+
+        this->pending.clear();
+        this->farmName = this->pendingName;
+        this->nameChanged = false;
+        int request = this->flushRequested;
+
+        // the actual serialization happens without holding the lock
+        guard.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        bool written = FarmFile::write(this->filename, this->farmName, this->mirror);
+        auto end = std::chrono::steady_clock::now();
+
+        this->lastWriteMs = std::chrono::duration<float, std::milli>(end - start).count();
+        this->writeCount++;
+
+        guard.lock();
+
+        // every flush asked for before the changes were taken is on disk now
+        if (request > this->flushWritten) {
+            this->flushWritten = request;
+            this->flushGood = written;
+            this->flushed.notify_all();
+        }
+    }
+}
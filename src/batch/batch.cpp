@@ -0,0 +1,45 @@
+/*
+ *  batch.cpp - entry point of the headless scenario evaluator
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+// this binary never opens a window, so sdl doesnt get to take over main
+#define SDL_MAIN_HANDLED
+#include "../main.hpp"
+
+// entry point
+// batch <farm.json> <crop.csv> <scenarios.jsonl> [results.csv]
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        printf("usage: batch <farm.json> <crop.csv> <scenarios.jsonl> [results.csv]\n");
+        printf("every line of the scenario file is a json object, all fields optional:\n");
+        printf("  {\"name\": \"...\", \"crop\": \"Corn\", \"plots\": {\"Bed 1\": \"Wheat\"}, \"yields\": {\"Corn\": 2.5},\n");
+        printf("   \"deviances\": {\"Bed 1\": 15}, \"devianceScale\": 1.5}\n");
+        return 1;
+    }
+
+    std::string cropFile = argv[2];
+    std::string outputFile = argc > 4 ? argv[4] : "results.csv";
+
+    // same crop table loading as the app, big tables go through the memory mapped loader
+    CropRegistry* registry = new CropRegistry();
+    std::error_code error;
+    if (!std::filesystem::exists(cropFile, error)) {
+        printf("ERROR: UNABLE TO OPEN %s\n", cropFile.c_str());
+        return 1;
+    }
+    if (std::filesystem::file_size(cropFile, error) > CSV_FAST_THRESHOLD && !error) {
+        registry->loadFromCSVFast(cropFile);
+    } else {
+        registry->loadFromCSV(cropFile);
+    }
+
+    ScenarioBatch* batch = new ScenarioBatch(registry);
+    if (!batch->loadFarm(argv[1])) {
+        return 1;
+    }
+
+    int status = batch->run(argv[3], outputFile);
+    delete batch;
+    return status;
+}
@@ -0,0 +1,476 @@
+/*
+ *  bench.cpp - timing runs for the heavier parts of the app
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// milliseconds since a starting point
+static float elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// a farm that lives in the temp folder and never gets written
+// planted farms get every crop but NO SELECTION in turn, otherwise every plot is empty
+static Farm* benchFarm(CropRegistry* registry, int plotCount, bool planted) {
+    std::string path = (std::filesystem::temp_directory_path() / "bench_farm.json").string();
+
+    // anything left over from an older build would be loaded on top of the plots added here
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::filesystem::remove(FarmFile::indexName(path), error);
+
+    // changes still go through the autosave like in the app, it just never writes them
+    Farm* farm = new Farm(path, registry, 60000);
+    farm->autosave->discard();
+
+    CropRegistry::CropEntry* crop = registry->access("NO SELECTION");
+    for (int i = 0; i < plotCount; i++) {
+        int x = (i % 1000) * PLOT_MIN_WIDTH;
+        int y = (i / 1000) * PLOT_MIN_HEIGHT;
+        farm->addPlot(new Plot(x, y, PLOT_MIN_WIDTH, PLOT_MIN_HEIGHT, "Bed " + std::to_string(i), 0, 0.0, crop));
+    }
+
+    // a table with nothing but NO SELECTION leaves the plots empty
+    int crops = registry->ordered.size() - 1;
+    if (planted && crops > 0) {
+        for (auto& plot : farm->plots) {
+            int index = 1 + plot->id % crops;
+            plot->updateProperties(registry->ordered[index], index);
+        }
+    }
+
+    return farm;
+}
+
+// drops any pending changes so deleting the farm has nothing left to submit
+static void discardChanges(Farm* farm) {
+    for (auto& plot : farm->dirtyPlots) {
+        plot->dirty = false;
+    }
+
+    farm->dirtyPlots.clear();
+}
+
+int Benchmark::run(std::string name, CropRegistry* registry) {
+    if (name == "history") {
+        Benchmark::history(registry);
+    } else if (name == "csv") {
+        Benchmark::csv();
+    } else if (name == "frame") {
+        Benchmark::frame(registry);
+    } else if (name == "simulation") {
+        Benchmark::simulation(registry);
+    } else if (name == "growth") {
+        Benchmark::growth(registry);
+    } else if (name == "rotation") {
+        Benchmark::rotation(registry);
+    } else if (name == "layout") {
+        Benchmark::layout(registry);
+    } else if (name == "heatmap") {
+        Benchmark::heatmap(registry);
+    } else if (name == "plants") {
+        Benchmark::plants(registry);
+    } else {
+        printf("unknown benchmark: %s\n", name.c_str());
+        return 1;
+    }
+
+    return 0;
+}
+
+void Benchmark::history(CropRegistry* registry) {
+    const int plotCount = 100000;
+    const int steps = 10000;
+    const int dragLength = 20;
+
+    Farm* farm = benchFarm(registry, plotCount, false);
+    std::vector<std::string> crops = registry->getKeyList();
+    std::mt19937 random(1);
+
+    // a mix of drags, crop changes, renames and deviation tweaks on random plots
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) {
+        Plot* plot = farm->plots[random() % plotCount];
+
+        switch (i % 4) {
+            case 0:
+                // every frame of a drag is recorded, the history keeps one edit for all of it
+                for (int j = 0; j < dragLength; j++) {
+                    SDL_Rect before = plot->bounds;
+                    plot->move(1, 1);
+                    farm->history.recordRect(plot, before, plot->bounds, true);
+                }
+                farm->history.seal();
+                break;
+            case 1: {
+                int index = random() % crops.size();
+                CropRegistry::CropEntry* entry = registry->access(crops[index]);
+                farm->history.recordCrop(plot, registry->access(plot->cropName), plot->cropIndex, entry, index);
+                plot->updateProperties(entry, index);
+                break;
+            }
+            case 2: {
+                char before[sizeof(plot->plotName)];
+                memcpy(before, plot->plotName, sizeof(before));
+                snprintf(plot->plotName, sizeof(plot->plotName), "Renamed %d", i);
+                farm->history.recordName(plot, before, plot->plotName);
+                farm->history.seal();
+                break;
+            }
+            case 3: {
+                float before = plot->yieldDeviance;
+                plot->yieldDeviance += 1.0f;
+                farm->history.recordDeviation(plot, before, plot->yieldDeviance);
+                farm->history.seal();
+                break;
+            }
+        }
+    }
+    float recordTime = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    int undone = 0;
+    while (farm->history.undo(farm)) {
+        undone++;
+    }
+    float undoTime = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    int redone = 0;
+    while (farm->history.redo(farm)) {
+        redone++;
+    }
+    float redoTime = elapsedMs(start);
+
+    // what copying the whole farm for every step would have cost
+    double naive = (double) plotCount * sizeof(PlotRecord) * steps;
+
+    printf("history: %d plots, %d steps (%d edits kept)\n", plotCount, steps, farm->history.size());
+    printf("  record: %.2f ms (%.3f us/step)\n", recordTime, recordTime * 1000.0f / steps);
+    printf("  undo:   %.2f ms (%.3f us/step, %d steps)\n", undoTime, undoTime * 1000.0f / std::max(undone, 1), undone);
+    printf("  redo:   %.2f ms (%.3f us/step, %d steps)\n", redoTime, redoTime * 1000.0f / std::max(redone, 1), redone);
+    printf("  memory: %.2f MB (full copies would be %.1f GB)\n", farm->history.memoryUse() / (1024.0 * 1024.0), naive / (1024.0 * 1024.0 * 1024.0));
+
+    discardChanges(farm);
+    delete farm;
+}
+
+void Benchmark::csv() {
+    const int rows = 500000;
+    std::string path = (std::filesystem::temp_directory_path() / "bench_crops.csv").string();
+
+    // synthetic crop table in the same layout as crop.csv
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        printf("ERROR: UNABLE TO WRITE %s\n", path.c_str());
+        return;
+    }
+
+    fprintf(file, "name, yield, red, green, blue\n");
+    for (int i = 0; i < rows; i++) {
+        fprintf(file, "Cultivar %d, %.2f, %d, %d, %d\n", i, (i % 997) / 10.0, i % 256, (i / 256) % 256, (i * 7) % 256);
+    }
+    fclose(file);
+
+    size_t bytes = std::filesystem::file_size(path);
+
+    // fastcsv on its own, without building any entries
+    auto start = std::chrono::steady_clock::now();
+    {
+        io::CSVReader<5> csvReader(path);
+        csvReader.read_header(io::ignore_missing_column, "name", "yield", "red", "green", "blue");
+        std::string name;
+        double yield;
+        int red, green, blue;
+        while (csvReader.read_row(name, yield, red, green, blue)) {
+        }
+    }
+    float parseTime = elapsedMs(start);
+
+    // the registry destructor is private, so the tables are left for the os to clean up
+    CropRegistry* registry = new CropRegistry();
+    start = std::chrono::steady_clock::now();
+    registry->loadFromCSV(path);
+    float time = elapsedMs(start);
+
+    // the mapped tokenizing on its own, the hash table inserts after it are serial
+    std::vector<std::vector<CropRegistry::CropEntry*>> chunks;
+    size_t mappedBytes = 0;
+    start = std::chrono::steady_clock::now();
+    CropRegistry::parseCSVFast(path, &chunks, &mappedBytes);
+    float mappedParseTime = elapsedMs(start);
+    for (auto& chunk : chunks) {
+        for (CropRegistry::CropEntry* entry : chunk) {
+            delete entry;
+        }
+    }
+
+    CropRegistry* fastRegistry = new CropRegistry();
+    start = std::chrono::steady_clock::now();
+    fastRegistry->loadFromCSVFast(path);
+    float fastTime = elapsedMs(start);
+
+    printf("csv: %d rows, %.1f MB\n", rows, bytes / (1024.0 * 1024.0));
+    printf("  fastcsv parse only: %.1f ms, %.3f GB/s\n", parseTime, bytes / (parseTime / 1000.0) / 1e9);
+    printf("  fastcsv: %.1f ms, %.0f rows/s, %.3f GB/s\n", time, rows / (time / 1000.0), bytes / (time / 1000.0) / 1e9);
+    printf("  mapped parse only: %.1f ms, %.3f GB/s\n", mappedParseTime, mappedBytes / (mappedParseTime / 1000.0) / 1e9);
+    printf("  mapped:  %.1f ms, %.0f rows/s, %.3f GB/s (%d crops, %.1f ms inserting)\n", fastTime, rows / (fastTime / 1000.0), bytes / (fastTime / 1000.0) / 1e9,
+        (int) fastRegistry->registry.size(), fastTime - mappedParseTime);
+
+    std::filesystem::remove(path);
+}
+
+void Benchmark::frame(CropRegistry* registry) {
+    const int plotCount = 10000;
+    const int frames = 1000;
+
+    if (!AllocTracker::enabled()) {
+        printf("frame: allocation tracking is compiled out, build with -DALLOC_TRACKING (compile.bat bench)\n");
+        return;
+    }
+
+    Farm* farm = benchFarm(registry, plotCount, false);
+    farm->update();
+    farm->submitChanges();
+
+    // the farm side of a frame where nothing happens
+    AllocTracker::Counts start = AllocTracker::current();
+    for (int i = 0; i < frames; i++) {
+        farm->update();
+        farm->submitChanges();
+    }
+    uint64_t idle = AllocTracker::since(start).total();
+
+    // the farm side of dragging one plot, the first frame of a drag is allowed to set things up
+    Plot* plot = farm->plots[plotCount / 2];
+    start = AllocTracker::current();
+    uint64_t firstFrame = 0;
+    for (int i = 0; i < frames; i++) {
+        SDL_Rect before = plot->bounds;
+        plot->move(i % 2 ? -1 : 1, 0);
+        farm->history.recordRect(plot, before, plot->bounds, true);
+        farm->markDirty(plot);
+        farm->submitChanges();
+
+        if (i == 0) {
+            firstFrame = AllocTracker::since(start).total();
+        }
+    }
+    farm->history.seal();
+    uint64_t drag = AllocTracker::since(start).total() - firstFrame;
+
+    printf("frame: %d plots, %d frames each\n", plotCount, frames);
+    printf("  idle: %llu allocations (%.2f per frame)\n", (unsigned long long) idle, (double) idle / frames);
+    printf("  drag: %llu on the first frame, %llu after (%.2f per frame)\n", (unsigned long long) firstFrame, (unsigned long long) drag, (double) drag / (frames - 1));
+
+    discardChanges(farm);
+    delete farm;
+}
+
+void Benchmark::simulation(CropRegistry* registry) {
+    const int plotCount = 1000000;
+    const int trials = 200;
+
+    // every plot gets a real crop and some deviance, otherwise there is nothing to sample
+    Farm* farm = benchFarm(registry, plotCount, true);
+    for (auto& plot : farm->plots) {
+        plot->yieldDeviance = 5 + plot->id % 20;
+    }
+
+    HarvestSimulation simulation;
+    simulation.trials = trials;
+    simulation.snapshot(farm, registry);
+
+    printf("simulation: %d plots, %d trials, %d threads\n", plotCount, trials, Parallel::workerCount());
+    for (float correlation : {0.0f, 0.5f}) {
+        simulation.correlation = correlation;
+        HarvestSimulation::Result result = simulation.simulate();
+        HarvestSimulation::Result again = simulation.simulate();
+
+        printf("  correlation %.1f: %.2f s, %.1fM samples/s, mean %.0f lbs, 5th-95th %.0f-%.0f, %s\n", correlation, result.seconds,
+            (double) trials * plotCount / result.seconds / 1e6, result.mean, result.p5, result.p95,
+            result.p50 == again.p50 && result.deviation == again.deviation ? "repeatable" : "NOT REPEATABLE");
+    }
+
+    discardChanges(farm);
+    delete farm;
+}
+
+void Benchmark::growth(CropRegistry* registry) {
+    const int plotCount = 1000000;
+
+    // every plot gets a real crop, empty plots are never planted
+    Farm* farm = benchFarm(registry, plotCount, true);
+
+    GrowthSimulation growth;
+    growth.snapshot(farm);
+    float seconds = growth.simulate();
+
+    // the stages looked up for a day should add up to what the run counted on that day
+    int mismatched = 0;
+    for (int day : {0, GROWTH_SEASON_DAYS / 2, GROWTH_SEASON_DAYS - 1}) {
+        int counts[GROWTH_STAGES] = {};
+        for (auto& plot : farm->plots) {
+            counts[growth.stageOf(plot->id, day)]++;
+        }
+        for (int stage = 0; stage < GROWTH_STAGES; stage++) {
+            mismatched += abs(counts[stage] - growth.totalsOn(day).stages[stage]);
+        }
+    }
+
+    printf("growth: %d plots, %d days, %d threads\n", plotCount, GROWTH_SEASON_DAYS, Parallel::workerCount());
+    printf("  season: %.2f s, %.1fM plot days/s, %.0f lbs harvested\n", seconds,
+        (double) plotCount * GROWTH_SEASON_DAYS / seconds / 1e6, growth.harvestedBy(GROWTH_SEASON_DAYS - 1));
+    printf("  looked up stages off by %d plots\n", mismatched);
+
+    discardChanges(farm);
+    delete farm;
+}
+
+void Benchmark::rotation(CropRegistry* registry) {
+    const int plotCount = 50000;
+
+    Farm* farm = benchFarm(registry, plotCount, false);
+
+    // the best crop of every plot every season, what the plan would be without any rules
+    double unconstrained = 0.0;
+    for (auto& plot : farm->plots) {
+        double best = 0.0;
+        for (auto& entry : registry->ordered) {
+            best = std::max(best, Plot::plantsFor(plot->bounds, entry->spacing) * (double) entry->avgYield);
+        }
+        unconstrained += best;
+    }
+
+    RotationPlanner planner;
+    planner.seasons = 4;
+    planner.gap = 1;
+    planner.sweeps = 100;
+    planner.quotas.assign(registry->ordered.size(), 20);
+    planner.snapshot(farm, registry);
+
+    printf("rotation: %d plots, %d seasons, %d sweeps, %d threads\n", (int) farm->plots.size(), planner.seasons, planner.sweeps, Parallel::workerCount());
+    RotationPlanner::Plan plan = planner.optimize();
+    printf("  %d chains in %.2f s, harvest %.0f lbs (%.1f%% of one crop everywhere), %.0f lbs lost to neighbors\n", plan.chains, plan.seconds,
+        plan.harvest, plan.harvest / std::max(1.0, unconstrained * planner.seasons) * 100.0, plan.penalty);
+    printf("  %d broken gaps or quotas\n", planner.violations(plan));
+
+    discardChanges(farm);
+    delete farm;
+}
+
+void Benchmark::layout(CropRegistry* registry) {
+    const int plotCount = 2000;
+
+    Farm* farm = benchFarm(registry, plotCount, false);
+
+    LayoutOptimizer optimizer;
+    optimizer.field = {0, 0, 4000, 3000};
+    optimizer.obstacles = {{500, 400, 300, 200}, {2000, 1500, 600, 100}, {3200, 200, 150, 2000}};
+    optimizer.sweeps = 200;
+    optimizer.targets.assign(registry->ordered.size(), 30);
+    optimizer.snapshot(farm, registry);
+
+    printf("layout: %d plots, %d obstacles, %d sweeps, %d threads\n", (int) farm->plots.size(), (int) optimizer.obstacles.size(), optimizer.sweeps,
+        Parallel::workerCount());
+    LayoutOptimizer::Layout layout = optimizer.optimize();
+    printf("  %d chains in %.2f s, harvest %.0f lbs, %d of %d plots placed\n", layout.chains, layout.seconds, layout.harvest, layout.placedCount,
+        plotCount);
+    printf("  %d placements out of the field, too close or on an obstacle\n", optimizer.conflicts(layout));
+
+    discardChanges(farm);
+    delete farm;
+}
+
+void Benchmark::heatmap(CropRegistry* registry) {
+    const int plotCount = 500000;
+    const int frames = 1000;
+
+    // every plot has something to shade
+    Farm* farm = benchFarm(registry, plotCount, true);
+
+    // no renderer, refreshing is all done on the cpu
+    Heatmap map(nullptr);
+    map.open = true;
+
+    auto start = std::chrono::steady_clock::now();
+    map.refresh(farm, registry);
+    float fullMs = elapsedMs(start);
+
+    // dragging a plot on screen back and forth, nothing about it changes the top of the ramp
+    Plot* plot = farm->plots[1];
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        plot->move(i % 2 ? -1 : 1, 0);
+        farm->markDirty(plot);
+        map.refresh(farm, registry);
+    }
+    float dragMs = elapsedMs(start);
+
+    // growing the plot with the highest yield per area every frame, so every frame recolors the whole farm
+    Plot* top = farm->plots[0];
+    for (auto& candidate : farm->plots) {
+        if (candidate->expectedYield > top->expectedYield) {
+            top = candidate;
+        }
+    }
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames / 10; i++) {
+        top->bounds.w += i % 2 ? -PLOT_LINE_SPACING : PLOT_LINE_SPACING;
+        farm->markDirty(top);
+        map.refresh(farm, registry);
+    }
+    float recolorMs = elapsedMs(start);
+
+    printf("heatmap: %d plots, %d threads\n", plotCount, Parallel::workerCount());
+    printf("  from scratch: %.1f ms\n", fullMs);
+    printf("  dragging: %.3f ms per frame\n", dragMs / frames);
+    printf("  new top every frame: %.2f ms per frame, top at %.3f lbs per plant spot\n", recolorMs / (frames / 10), map.scaleTop());
+
+    discardChanges(farm);
+    delete farm;
+}
+
+void Benchmark::plants(CropRegistry* registry) {
+    const int plotCount = 500000;
+    const int frames = 1000;
+
+    // plots fill at every spacing the table has
+    Farm* farm = benchFarm(registry, plotCount, true);
+
+    PlantStore store;
+    auto start = std::chrono::steady_clock::now();
+    store.refresh(farm, registry);
+    float sowMs = elapsedMs(start);
+
+    // counting every live plant again, the pass a per plant simulation step would make
+    start = std::chrono::steady_clock::now();
+    int64_t counted = 0;
+    for (int id = 0; id < plotCount; id++) {
+        const uint8_t* run = store.plantsOf(id);
+        for (int64_t i = 0, count = farm->plots[id]->plantCount(); i < count; i++) {
+            counted += run[i] >> 7;
+        }
+    }
+    float scanMs = elapsedMs(start);
+
+    // growing and shrinking one plot, so it keeps outgrowing its run
+    Plot* plot = farm->plots[1];
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        plot->bounds.w += i % 2 ? -PLOT_MIN_WIDTH : PLOT_MIN_WIDTH;
+        farm->markDirty(plot);
+        store.refresh(farm, registry);
+    }
+    float resizeMs = elapsedMs(start);
+
+    printf("plants: %d plots, %lld plants, %d threads\n", plotCount, (long long) store.plants(), Parallel::workerCount());
+    printf("  sowing from scratch: %.1f ms, %.1f M plants/s\n", sowMs, store.plants() / std::max(sowMs, 1e-3f) / 1000.0f);
+    printf("  checked byte by byte: %.1f ms, %lld up, store says %lld\n", scanMs, (long long) counted, (long long) store.living());
+    printf("  resizing: %.3f ms per frame\n", resizeMs / frames);
+    printf("  %.1f MB, %.2f bytes per plant\n", store.bytes() / (1024.0 * 1024.0), (double) store.bytes() / store.plants());
+
+    discardChanges(farm);
+    delete farm;
+}
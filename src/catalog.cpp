@@ -0,0 +1,271 @@
+/*
+ *  catalog.cpp - columnar crop catalog merged from several csv files
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// columns a catalog file can have, anything else is skipped
+#define CATALOG_COLUMN_CROP 0
+#define CATALOG_COLUMN_REGION 1
+#define CATALOG_COLUMN_SEASON 2
+#define CATALOG_COLUMN_CULTIVAR 3
+#define CATALOG_COLUMN_YIELD 4
+
+// one parsed row, the strings point into the mapped file until the merge is done
+struct CatalogRow {
+    std::string_view crop;
+    std::string_view region;
+    std::string_view season;
+    std::string_view cultivar;
+    double yield;
+};
+
+// crop, region, season and cultivar codes, identifies a row while merging
+typedef std::array<int, 4> CatalogKey;
+
+struct CatalogKeyHash {
+    size_t operator()(const CatalogKey& key) const {
+        size_t hash = 0;
+        for (int code : key) {
+            hash = hash * 0x9E3779B97F4A7C15ull + code;
+        }
+        return hash ^ (hash >> 29);
+    }
+};
+
+CropCatalog::Dictionary::Dictionary() {
+    this->encode("");
+}
+
+int CropCatalog::Dictionary::encode(std::string_view value) {
+    auto result = this->codes.try_emplace(std::string(value), (int) this->values.size());
+    if (result.second) {
+        this->values.push_back(result.first->first);
+    }
+
+    return result.first->second;
+}
+
+int CropCatalog::Dictionary::find(const std::string& value) {
+    auto found = this->codes.find(value);
+    return found == this->codes.end() ? -1 : found->second;
+}
+
+bool CropCatalog::load(std::vector<std::string> filenames) {
+    *this = CropCatalog();
+    this->sources = filenames;
+
+    // every file stays mapped until the merge is done, the parsed rows point into them
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<std::vector<int>> columns(filenames.size());
+
+    // every chunk of every file is one piece of work, they all go into a single parallel loop
+    struct Chunk {
+        int file;
+        const char* begin;
+        const char* end;
+        std::vector<CatalogRow> rows;
+    };
+    std::vector<Chunk> chunks;
+
+    bool good = true;
+    for (int i = 0; i < (int) filenames.size(); i++) {
+        files.push_back(std::make_unique<MappedFile>(filenames[i]));
+        MappedFile* file = files.back().get();
+        if (!file->good()) {
+            printf("ERROR: UNABLE TO OPEN %s\n", filenames[i].c_str());
+            good = false;
+            continue;
+        }
+
+        const char* end = file->data + file->size;
+        const char* body;
+        for (std::string& column : CsvScanner::header(file->data, end, &body)) {
+            if (column == "crop" || column == "name") {
+                columns[i].push_back(CATALOG_COLUMN_CROP);
+            } else if (column == "region") {
+                columns[i].push_back(CATALOG_COLUMN_REGION);
+            } else if (column == "season") {
+                columns[i].push_back(CATALOG_COLUMN_SEASON);
+            } else if (column == "cultivar") {
+                columns[i].push_back(CATALOG_COLUMN_CULTIVAR);
+            } else if (column == "yield") {
+                columns[i].push_back(CATALOG_COLUMN_YIELD);
+            } else {
+                columns[i].push_back(-1);
+            }
+        }
+
+        // a file without crops cant be merged with anything
+        if (std::find(columns[i].begin(), columns[i].end(), CATALOG_COLUMN_CROP) == columns[i].end()) {
+            printf("ERROR: %s HAS NO CROP COLUMN\n", filenames[i].c_str());
+            good = false;
+            continue;
+        }
+
+        std::vector<const char*> bounds = CsvScanner::chunks(body, end);
+        for (int j = 0; j + 1 < (int) bounds.size(); j++) {
+            chunks.push_back(Chunk{i, bounds[j], bounds[j + 1], {}});
+        }
+    }
+
+    Parallel::forRange(chunks.size(), 1, [&](int begin, int finish) {
+        for (int i = begin; i < finish; i++) {
+            Chunk& chunk = chunks[i];
+            std::vector<int>& layout = columns[chunk.file];
+
+            CsvScanner::rows(chunk.begin, chunk.end, [&](std::vector<std::string_view>& fields) {
+                CatalogRow row = {};
+                for (int j = 0; j < (int) fields.size() && j < (int) layout.size(); j++) {
+                    switch (layout[j]) {
+                        case CATALOG_COLUMN_CROP: row.crop = fields[j]; break;
+                        case CATALOG_COLUMN_REGION: row.region = fields[j]; break;
+                        case CATALOG_COLUMN_SEASON: row.season = fields[j]; break;
+                        case CATALOG_COLUMN_CULTIVAR: row.cultivar = fields[j]; break;
+                        case CATALOG_COLUMN_YIELD: std::from_chars(fields[j].data(), fields[j].data() + fields[j].size(), row.yield); break;
+                    }
+                }
+
+                // rows without a crop are blank lines
+                if (!row.crop.empty()) {
+                    chunk.rows.push_back(row);
+                }
+            });
+        }
+    });
+
+    // chunks are in file order, so merging them in order lets later files overwrite earlier ones
+    size_t total = 0;
+    for (Chunk& chunk : chunks) {
+        total += chunk.rows.size();
+    }
+
+    std::unordered_map<CatalogKey, int, CatalogKeyHash> index;
+    index.reserve(total);
+    this->crop.reserve(total);
+    this->region.reserve(total);
+    this->season.reserve(total);
+    this->cultivar.reserve(total);
+    this->yield.reserve(total);
+    this->source.reserve(total);
+
+    for (Chunk& chunk : chunks) {
+        for (CatalogRow& row : chunk.rows) {
+            CatalogKey key = {this->crops.encode(row.crop), this->regions.encode(row.region),
+                this->seasons.encode(row.season), this->cultivars.encode(row.cultivar)};
+
+            auto result = index.try_emplace(key, (int) this->crop.size());
+            if (result.second) {
+                this->crop.push_back(key[0]);
+                this->region.push_back(key[1]);
+                this->season.push_back(key[2]);
+                this->cultivar.push_back(key[3]);
+                this->yield.push_back(row.yield);
+                this->source.push_back(chunk.file);
+            } else {
+                this->yield[result.first->second] = row.yield;
+                this->source[result.first->second] = chunk.file;
+            }
+        }
+    }
+
+    // sorting by key turns every filtered lookup into a binary search over a contiguous range
+    int count = this->crop.size();
+    std::vector<int> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return std::tie(this->crop[a], this->region[a], this->season[a], this->cultivar[a]) <
+            std::tie(this->crop[b], this->region[b], this->season[b], this->cultivar[b]);
+    });
+
+    auto permute = [&](auto& column) {
+        std::remove_reference_t<decltype(column)> sorted(count);
+        for (int i = 0; i < count; i++) {
+            sorted[i] = column[order[i]];
+        }
+        column.swap(sorted);
+    };
+
+    permute(this->crop);
+    permute(this->region);
+    permute(this->season);
+    permute(this->cultivar);
+    permute(this->yield);
+    permute(this->source);
+
+    return good;
+}
+
+int CropCatalog::rows() {
+    return this->crop.size();
+}
+
+std::pair<int, int> CropCatalog::range(int crop, int region, int season, int depth) {
+    int key[3] = {crop, region, season};
+
+    // compares a row against the key, only looking at the first depth columns
+    auto compare = [&](int row) {
+        int values[3] = {this->crop[row], this->region[row], this->season[row]};
+        for (int i = 0; i < depth; i++) {
+            if (values[i] != key[i]) {
+                return values[i] < key[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    };
+
+    int low = 0;
+    int high = this->rows();
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (compare(middle) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    int first = low;
+    high = this->rows();
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (compare(middle) <= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return {first, low};
+}
+
+void CropCatalog::filter(int crop, int region, int season, std::vector<int>* out) {
+    out->clear();
+
+    // the sort order only helps with a prefix of the key, a season without a region is checked row by row
+    int depth = region < 0 ? 1 : (season < 0 ? 2 : 3);
+    std::pair<int, int> rows = this->range(crop, region, season, depth);
+
+    for (int i = rows.first; i < rows.second; i++) {
+        if (season < 0 || this->season[i] == season) {
+            out->push_back(i);
+        }
+    }
+}
+
+double CropCatalog::averageYield(int crop, int region, int season, int* count) {
+    int depth = region < 0 ? 1 : (season < 0 ? 2 : 3);
+    std::pair<int, int> rows = this->range(crop, region, season, depth);
+
+    double total = 0.0;
+    *count = 0;
+    for (int i = rows.first; i < rows.second; i++) {
+        if (season < 0 || this->season[i] == season) {
+            total += this->yield[i];
+            (*count)++;
+        }
+    }
+
+    return *count > 0 ? total / *count : 0.0;
+}
@@ -0,0 +1,403 @@
+/*
+ *  csvfast.cpp - memory mapped, simd scanned crop table loading
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+MappedFile::MappedFile(std::string filename) {
+    this->data = nullptr;
+    this->size = 0;
+
+#ifdef _WIN32
+    this->mapping = nullptr;
+    this->file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->file == INVALID_HANDLE_VALUE) {
+        this->file = nullptr;
+        return;
+    }
+
+    LARGE_INTEGER length;
+    GetFileSizeEx(this->file, &length);
+    this->size = length.QuadPart;
+
+    if (this->size > 0) {
+        this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (this->mapping) {
+            this->data = (const char*) MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+    }
+#else
+    this->fd = open(filename.c_str(), O_RDONLY);
+    if (this->fd < 0) {
+        return;
+    }
+
+    struct stat info;
+    fstat(this->fd, &info);
+    this->size = info.st_size;
+
+    if (this->size > 0) {
+        void* view = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+        if (view != MAP_FAILED) {
+            this->data = (const char*) view;
+            // the whole file is read front to back
+            madvise(view, this->size, MADV_SEQUENTIAL);
+        }
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (this->data) {
+        UnmapViewOfFile(this->data);
+    }
+    if (this->mapping) {
+        CloseHandle(this->mapping);
+    }
+    if (this->file) {
+        CloseHandle(this->file);
+    }
+#else
+    if (this->data) {
+        munmap((void*) this->data, this->size);
+    }
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+#endif
+}
+
+// an empty file is fine, it just has no rows
+bool MappedFile::good() {
+    return this->data != nullptr || this->size == 0;
+}
+
+// writes the offset of every ',' and '\n' in data to out, returns how many were found
+static int findDelimitersScalar(const char* data, int size, uint32_t* out) {
+    int count = 0;
+    for (int i = 0; i < size; i++) {
+        if (data[i] == ',' || data[i] == '\n') {
+            out[count++] = i;
+        }
+    }
+
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// 16 bytes at a time, every matching byte sets one bit of the mask
+__attribute__((target("sse2")))
+static int findDelimitersSSE2(const char* data, int size, uint32_t* out) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    int count = 0;
+    int i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*) (data + i));
+        uint32_t mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, comma), _mm_cmpeq_epi8(block, newline)));
+
+        while (mask) {
+            out[count++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+
+    // the tail is done a byte at a time, its offsets start from this block
+    for (; i < size; i++) {
+        if (data[i] == ',' || data[i] == '\n') {
+            out[count++] = i;
+        }
+    }
+
+    return count;
+}
+
+// same thing 32 bytes at a time
+__attribute__((target("avx2")))
+static int findDelimitersAVX2(const char* data, int size, uint32_t* out) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    int count = 0;
+    int i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*) (data + i));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, comma), _mm256_cmpeq_epi8(block, newline)));
+
+        while (mask) {
+            out[count++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+
+    // the tail is done a byte at a time, its offsets start from this block
+    for (; i < size; i++) {
+        if (data[i] == ',' || data[i] == '\n') {
+            out[count++] = i;
+        }
+    }
+
+    return count;
+}
+#endif
+
+// picks the widest version the cpu supports, once
+typedef int (*DelimiterScan)(const char*, int, uint32_t*);
+
+static DelimiterScan pickDelimiterScan() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findDelimitersAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return findDelimitersSSE2;
+    }
+#endif
+    return findDelimitersScalar;
+}
+
+// strips the same characters fastcsv trims, plus the \r from windows line endings
+static void trimField(const char** begin, const char** end) {
+    while (*begin < *end && (**begin == ' ' || **begin == '\t')) {
+        (*begin)++;
+    }
+    while (*end > *begin && ((*end)[-1] == ' ' || (*end)[-1] == '\t' || (*end)[-1] == '\r')) {
+        (*end)--;
+    }
+}
+
+std::vector<std::string> CsvScanner::header(const char* data, const char* end, const char** body) {
+    std::vector<std::string> columns;
+    const char* headerEnd = data ? (const char*) memchr(data, '\n', end - data) : nullptr;
+    if (headerEnd == nullptr) {
+        headerEnd = end;
+    }
+
+    const char* field = data;
+    for (const char* at = data; at <= headerEnd && field; at++) {
+        if (at == headerEnd || *at == ',') {
+            const char* fieldBegin = field;
+            const char* fieldEnd = at;
+            trimField(&fieldBegin, &fieldEnd);
+            columns.push_back(std::string(fieldBegin, fieldEnd));
+            field = at + 1;
+        }
+    }
+
+    *body = headerEnd < end ? headerEnd + 1 : end;
+    return columns;
+}
+
+std::vector<const char*> CsvScanner::chunks(const char* begin, const char* end) {
+    int chunkCount = std::max(1, std::min(Parallel::workerCount() * 4, (int) ((end - begin) / CSV_SCAN_WINDOW)));
+    std::vector<const char*> bounds(chunkCount + 1);
+    bounds[0] = begin;
+    bounds[chunkCount] = end;
+
+    for (int i = 1; i < chunkCount; i++) {
+        const char* guess = begin + (end - begin) * i / chunkCount;
+        guess = std::max(guess, bounds[i - 1]);
+        const char* newline = (const char*) memchr(guess, '\n', end - guess);
+        bounds[i] = newline ? newline + 1 : end;
+    }
+
+    return bounds;
+}
+
+void CsvScanner::rows(const char* begin, const char* end, const std::function<void(std::vector<std::string_view>&)>& row) {
+    static DelimiterScan scan = pickDelimiterScan();
+    std::vector<uint32_t> delimiters(CSV_SCAN_WINDOW);
+
+    // fields of the row being read, they point straight into the buffer
+    std::vector<std::string_view> fields;
+
+    auto takeField = [&](const char* fieldBegin, const char* fieldEnd) {
+        trimField(&fieldBegin, &fieldEnd);
+        fields.push_back(std::string_view(fieldBegin, fieldEnd - fieldBegin));
+    };
+
+    auto finishRow = [&]() {
+        row(fields);
+        fields.clear();
+    };
+
+    const char* at = begin;
+    while (at < end) {
+        // scan a window, only rows that end inside it are handled this round
+        int length = std::min((long) CSV_SCAN_WINDOW, (long) (end - at));
+        int count = scan(at, length, delimiters.data());
+        const char* field = at;
+        const char* next = at;
+
+        for (int i = 0; i < count; i++) {
+            const char* delimiter = at + delimiters[i];
+            takeField(field, delimiter);
+            field = delimiter + 1;
+
+            if (*delimiter == '\n') {
+                finishRow();
+                next = field;
+            }
+        }
+
+        // the last row of the file might not end with a newline
+        if (at + length == end && next < end) {
+            takeField(field, end);
+            finishRow();
+            next = end;
+        }
+
+        // a single row longer than the window, skip it rather than loop forever
+        if (next == at) {
+            const char* newline = (const char*) memchr(at, '\n', end - at);
+            next = newline ? newline + 1 : end;
+        }
+
+        // anything after the last newline is read again in the next window
+        fields.clear();
+        at = next;
+    }
+}
+
+// columns the registry cares about, anything else in the file is skipped
+#define CSV_COLUMN_NAME 0
+#define CSV_COLUMN_YIELD 1
+#define CSV_COLUMN_RED 2
+#define CSV_COLUMN_GREEN 3
+#define CSV_COLUMN_BLUE 4
+#define CSV_COLUMN_DAYS 5
+#define CSV_COLUMN_START 6
+#define CSV_COLUMN_FAMILY 7
+#define CSV_COLUMN_SPACING 8
+#define CSV_COLUMN_COUNT 9
+
+// parses every row in [begin, end), which has to start at the beginning of a line
+static void parseRows(const char* begin, const char* end, std::vector<int>& columns, std::vector<CropRegistry::CropEntry*>* entries) {
+    double values[CSV_COLUMN_COUNT];
+
+    CsvScanner::rows(begin, end, [&](std::vector<std::string_view>& fields) {
+        std::string_view name;
+        std::string_view family;
+        memset(values, 0, sizeof(values));
+        values[CSV_COLUMN_DAYS] = CROP_DEFAULT_GROWTH_DAYS;
+        values[CSV_COLUMN_START] = CROP_DEFAULT_PLANTING_DAY;
+        values[CSV_COLUMN_SPACING] = CROP_DEFAULT_SPACING;
+
+        // stores each field into whichever column it belongs to
+        for (int i = 0; i < (int) fields.size() && i < (int) columns.size(); i++) {
+            if (columns[i] == CSV_COLUMN_NAME) {
+                name = fields[i];
+            } else if (columns[i] == CSV_COLUMN_FAMILY) {
+                family = fields[i];
+            } else if (columns[i] > CSV_COLUMN_NAME) {
+                std::from_chars(fields[i].data(), fields[i].data() + fields[i].size(), values[columns[i]]);
+            }
+        }
+
+        // rows without a name are blank lines
+        if (!name.empty()) {
+            CropRegistry::CropEntry* entry = new CropRegistry::CropEntry(std::string(name), values[CSV_COLUMN_YIELD],
+                (int) values[CSV_COLUMN_RED], (int) values[CSV_COLUMN_GREEN], (int) values[CSV_COLUMN_BLUE]);
+            entry->growthDays = std::max(1, (int) values[CSV_COLUMN_DAYS]);
+            entry->plantingDay = std::max(0, (int) values[CSV_COLUMN_START]);
+            entry->spacing = std::max(CROP_MIN_SPACING, (int) values[CSV_COLUMN_SPACING]);
+            if (!family.empty()) {
+                entry->family = family;
+            }
+            entries->push_back(entry);
+        }
+    });
+}
+
+bool CropRegistry::parseCSVFast(std::string filename, std::vector<std::vector<CropEntry*>>* chunks, size_t* size) {
+    MappedFile file(filename);
+    if (!file.good()) {
+        printf("ERROR: UNABLE TO OPEN %s\n", filename.c_str());
+        return false;
+    }
+
+    const char* end = file.data + file.size;
+    *size = file.size;
+
+    // the header decides which column is which
+    const char* body;
+    std::vector<int> columns;
+    for (std::string& column : CsvScanner::header(file.data, end, &body)) {
+        if (column == "name") {
+            columns.push_back(CSV_COLUMN_NAME);
+        } else if (column == "yield") {
+            columns.push_back(CSV_COLUMN_YIELD);
+        } else if (column == "red") {
+            columns.push_back(CSV_COLUMN_RED);
+        } else if (column == "green") {
+            columns.push_back(CSV_COLUMN_GREEN);
+        } else if (column == "blue") {
+            columns.push_back(CSV_COLUMN_BLUE);
+        } else if (column == "days") {
+            columns.push_back(CSV_COLUMN_DAYS);
+        } else if (column == "start") {
+            columns.push_back(CSV_COLUMN_START);
+        } else if (column == "family") {
+            columns.push_back(CSV_COLUMN_FAMILY);
+        } else if (column == "spacing") {
+            columns.push_back(CSV_COLUMN_SPACING);
+        } else {
+            columns.push_back(-1);
+        }
+    }
+
+    // every chunk fills its own list, so they stay in file order
+    std::vector<const char*> bounds = CsvScanner::chunks(body, end);
+    int chunkCount = bounds.size() - 1;
+    chunks->assign(chunkCount, std::vector<CropEntry*>());
+
+    Parallel::forRange(chunkCount, 1, [&](int begin, int finish) {
+        for (int i = begin; i < finish; i++) {
+            parseRows(bounds[i], bounds[i + 1], columns, &(*chunks)[i]);
+        }
+    });
+
+    return true;
+}
+
+bool CropRegistry::loadFromCSVFast(std::string filename) {
+    std::vector<std::vector<CropEntry*>> chunks;
+    size_t fileSize;
+    if (!CropRegistry::parseCSVFast(filename, &chunks, &fileSize)) {
+        return false;
+    }
+
+    size_t total = 0;
+    for (auto& chunk : chunks) {
+        total += chunk.size();
+    }
+
+    // chunks are added in file order so the first duplicate wins like in loadFromCSV
+    this->reserve(total);
+    for (auto& chunk : chunks) {
+        this->addEntries(chunk);
+    }
+
+    // adds a type for null selections, the ordered list puts it at index 0
+    this->addEntry("NO SELECTION", 0.0, 120, 120, 120);
+    this->buildIndex();
+
+    return true;
+}
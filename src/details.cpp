@@ -0,0 +1,102 @@
+/*
+ *  details.cpp - loading plot details in the background after an index load
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+DetailLoader::DetailLoader(std::string filename, std::vector<Plot*>& plots, std::vector<PlotSpan>& spans) {
+    this->filename = filename;
+    this->plots = plots;
+    this->spans = spans;
+    this->cancelled = false;
+    this->finished = false;
+
+    this->worker = std::thread(&DetailLoader::run, this);
+}
+
+DetailLoader::~DetailLoader() {
+    this->cancelled = true;
+    this->wait();
+}
+
+// copies the name and deviation out of one plot object
+void DetailLoader::loadDetails(Plot* plot, const char* begin, const char* end, Json::CharReader* reader) {
+    Json::Value data;
+    if (reader->parse(begin, end, &data, nullptr)) {
+        std::string name = data["name"].asString();
+        strncpy(plot->plotName, name.c_str(), sizeof(plot->plotName) - 1);
+        plot->yieldDeviance = data["deviation"].asDouble();
+    }
+
+    // even a broken record counts as loaded, otherwise anything waiting on it would hang
+    plot->details.store(PLOT_DETAILS_READY, std::memory_order_release);
+}
+
+void DetailLoader::require(Plot* plot) {
+    int expected = PLOT_DETAILS_PENDING;
+
+    // claim it ourselves and read just this plot's bytes
+    if (plot->details.compare_exchange_strong(expected, PLOT_DETAILS_LOADING)) {
+        PlotSpan& span = this->spans[plot->id];
+        std::string text(span.end - span.begin, '\0');
+
+        std::ifstream file(this->filename, std::ifstream::binary);
+        file.seekg(span.begin);
+        file.read(&text[0], text.size());
+
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        DetailLoader::loadDetails(plot, text.data(), text.data() + text.size(), reader.get());
+        return;
+    }
+
+    // the worker has it, which only takes a moment
+    while (!plot->hasDetails()) {
+        std::this_thread::yield();
+    }
+}
+
+bool DetailLoader::done() {
+    return this->finished;
+}
+
+void DetailLoader::wait() {
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+}
+
+void DetailLoader::run() {
+    std::string buffer;
+    if (!FarmFile::readAll(this->filename, &buffer)) {
+        printf("ERROR: UNABLE TO READ %s FOR PLOT DETAILS\n", this->filename.c_str());
+    }
+
+    Json::CharReaderBuilder builder;
+
+    Parallel::forRange(this->plots.size(), PARALLEL_BLOCK, [&](int begin, int end) {
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+        for (int i = begin; i < end && !this->cancelled; i++) {
+            Plot* plot = this->plots[i];
+            PlotSpan& span = this->spans[i];
+            int expected = PLOT_DETAILS_PENDING;
+
+            // skip anything the main thread already loaded or is loading
+            if (!plot->details.compare_exchange_strong(expected, PLOT_DETAILS_LOADING)) {
+                continue;
+            }
+
+            // a file that shrank underneath us still has to release every plot
+            if (span.end > (int) buffer.size()) {
+                plot->details.store(PLOT_DETAILS_READY, std::memory_order_release);
+                continue;
+            }
+
+            DetailLoader::loadDetails(plot, buffer.data() + span.begin, buffer.data() + span.end, reader.get());
+        }
+    });
+
+    this->finished = true;
+}
@@ -0,0 +1,206 @@
+/*
+ *  farm.cpp - a single farm, its plots, loading and autosaving
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+Farm::Farm(std::string filename, CropRegistry* registry, int autosaveDelay) {
+    this->filename = filename;
+    this->detailLoader = nullptr;
+    this->nameDirty = false;
+    this->autosaveSeeded = false;
+    this->version = 0;
+    this->plotBytes = 0;
+    this->autosave = new Autosave(filename, autosaveDelay);
+
+    // the index has everything needed to draw, so if it is up to date
+    // the first frame can show without waiting for the json
+    std::vector<PlotSpan> spans;
+    std::string buffer;
+
+    if (FarmFile::loadIndex(filename, registry, &this->name, &this->plots, &spans)) {
+        this->detailLoader = new DetailLoader(filename, this->plots, spans);
+    } else if (FarmFile::readAll(filename, &buffer)) {
+        // loading from a file, farm.json
+        // plots are parsed in parallel straight into the plot list
+        if (!FarmFile::load(buffer, registry, &this->name, &this->plots, &spans)) {
+            this->name = std::string("UNAMED FARM");
+        }
+    } else {
+        // loading farm setup if there is no file found
+        this->name = std::string("UNAMED FARM");
+    }
+
+    for (auto& plot : this->plots) {
+        this->plotBytes += Farm::plotSize(plot);
+    }
+
+    // with everything loaded the autosave can start right away, otherwise it waits for the details
+    if (this->detailLoader == nullptr) {
+        this->seedAutosave();
+
+        // build the index now so the next load is quick
+        if (!this->plots.empty()) {
+            std::vector<PlotRecord> records(this->plots.size());
+            for (int i = 0; i < (int) this->plots.size(); i++) {
+                this->plots[i]->toRecord(&records[i]);
+            }
+
+            FarmFile::writeIndex(filename, this->name, records, spans);
+        }
+    }
+}
+
+Farm::~Farm() {
+    // the autosave cant write anything until it has the full farm
+    if (!this->autosaveSeeded) {
+        this->detailLoader->wait();
+        this->seedAutosave();
+    }
+
+    // stops the autosave, which writes out any changes still waiting
+    this->submitChanges();
+    delete this->autosave;
+    delete this->detailLoader;
+
+    for (auto& plot : this->plots) {
+        delete plot;
+    }
+}
+
+void Farm::update() {
+    // start autosaving once the background loader has filled in every plot
+    if (!this->autosaveSeeded && this->detailLoader->done()) {
+        this->seedAutosave();
+    }
+}
+
+// adds a new plot to list
+void Farm::addPlot(Plot* plot) {
+    // ids are just the position in the list, plots are never removed
+    plot->id = this->plots.size();
+    this->plots.push_back(plot);
+    this->plotBytes += Farm::plotSize(plot);
+}
+
+bool Farm::save(std::string filename) {
+    // every name has to be there before anything is written
+    if (this->detailLoader) {
+        this->detailLoader->wait();
+    }
+
+    // the farm's own file is only ever written by the autosave worker, so a save cant overlap an autosave
+    if (filename == this->filename) {
+        if (!this->autosaveSeeded) {
+            this->seedAutosave();
+        }
+
+        this->submitChanges();
+        return this->autosave->flush();
+    }
+
+    // copy every plot out, empty farms are saved too
+    std::vector<PlotRecord> records(this->plots.size());
+    for (int i = 0; i < (int) this->plots.size(); i++) {
+        this->plots[i]->toRecord(&records[i]);
+    }
+
+    return FarmFile::write(filename, this->name, records);
+}
+
+// flags a plot as changed, each plot is only queued once per frame
+void Farm::markDirty(Plot* plot) {
+    plot->revision = ++this->version;
+    this->changeLog[this->version % FARM_CHANGE_LOG] = plot->id;
+
+    if (!plot->dirty) {
+        plot->dirty = true;
+        this->dirtyPlots.push_back(plot);
+    }
+}
+
+// sends everything that changed this frame to the autosave in one go
+// the cost here is proportional to the number of changed plots, not the size of the farm
+void Farm::submitChanges() {
+    if (this->nameDirty) {
+        this->autosave->submitName(this->name);
+        this->nameDirty = false;
+    }
+
+    if (this->dirtyPlots.empty()) {
+        return;
+    }
+
+    // resizing keeps the capacity and the records' strings, so a drag only allocates on its first frame
+    this->submitted.resize(this->dirtyPlots.size());
+    for (int i = 0; i < (int) this->dirtyPlots.size(); i++) {
+        this->requireDetails(this->dirtyPlots[i]);
+        this->dirtyPlots[i]->toRecord(&this->submitted[i]);
+        this->dirtyPlots[i]->dirty = false;
+    }
+
+    this->dirtyPlots.clear();
+    this->autosave->submit(this->submitted);
+}
+
+// only ever called once, after every plot has its details
+void Farm::seedAutosave() {
+    std::vector<PlotRecord> records(this->plots.size());
+    for (int i = 0; i < (int) this->plots.size(); i++) {
+        this->plots[i]->toRecord(&records[i]);
+    }
+
+    this->autosave->seed(this->name, records);
+    this->autosaveSeeded = true;
+}
+
+void Farm::requireDetails(Plot* plot) {
+    if (this->detailLoader) {
+        this->detailLoader->require(plot);
+    }
+}
+
+void Farm::changedSince(uint64_t version, std::vector<int>* ids) {
+    if (this->version - version <= FARM_CHANGE_LOG) {
+        for (uint64_t at = version + 1; at <= this->version; at++) {
+            ids->push_back(this->changeLog[at % FARM_CHANGE_LOG]);
+        }
+    } else {
+        for (auto& plot : this->plots) {
+            if (plot->revision > version) {
+                ids->push_back(plot->id);
+            }
+        }
+    }
+}
+
+// the plot itself plus whatever its crop name puts on the heap
+size_t Farm::plotSize(Plot* plot) {
+    size_t size = sizeof(Plot);
+    if (plot->cropName.capacity() > 15) {
+        size += plot->cropName.capacity() + 1;
+    }
+    return size;
+}
+
+// called every frame, so nothing here walks the plots
+size_t Farm::memoryUse() {
+    size_t total = sizeof(Farm) + this->plots.capacity() * sizeof(Plot*) + this->plotBytes;
+
+    // undo history, expanded rows and the buffers changes pass through on their way to the autosave
+    total += this->history.memoryUse();
+    total += this->expandedPlots.capacity() * sizeof(int);
+    total += this->dirtyPlots.capacity() * sizeof(Plot*);
+    total += this->submitted.capacity() * sizeof(PlotRecord);
+
+    // the autosave keeps a record of every plot, and the loader where each plot is in the json
+    if (this->autosaveSeeded) {
+        total += this->plots.size() * sizeof(PlotRecord);
+    }
+    if (this->detailLoader) {
+        total += this->plots.size() * (sizeof(Plot*) + sizeof(PlotSpan));
+    }
+
+    return total;
+}
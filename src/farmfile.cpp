@@ -0,0 +1,411 @@
+/*
+ *  farmfile.cpp - reading and writing farm files
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// one plot in the index file, written exactly as laid out here
+struct IndexRecord {
+    int32_t x, y, w, h;
+    // position in the index's crop name table
+    int32_t crop;
+    int32_t cropIndex;
+    // where the plot's full object is in the json
+    int32_t begin, end;
+};
+
+// size and modification time of the json, used to tell if an index is out of date
+static bool jsonStamp(std::string filename, int64_t* size, int64_t* time) {
+    std::error_code error;
+    *size = std::filesystem::file_size(filename, error);
+    if (error) {
+        return false;
+    }
+
+    *time = std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+    return !error;
+}
+
+// strings in the index are stored as a length followed by the characters
+static void writeString(std::ofstream& file, const std::string& string) {
+    uint32_t length = string.size();
+    file.write((char*) &length, sizeof(length));
+    file.write(string.data(), length);
+}
+
+static bool readString(std::ifstream& file, std::string* string) {
+    uint32_t length = 0;
+    file.read((char*) &length, sizeof(length));
+    string->resize(length);
+    file.read(&(*string)[0], length);
+    return file.good();
+}
+
+bool FarmFile::write(std::string filename, std::string farmName, std::vector<PlotRecord>& records) {
+    // main object to be serialized
+    Json::Value farmData;
+    farmData["name"] = farmName;
+    farmData["size"] = (int) records.size();
+
+    // json array holding objects which are the actual plots
+    Json::Value plots(Json::arrayValue);
+
+    for (auto& record : records) {
+        Json::Value plotData;
+
+        // serialize all the data
+        plotData["name"] = record.name;
+        plotData["x"] = record.bounds.x;
+        plotData["y"] = record.bounds.y;
+        plotData["width"] = record.bounds.w;
+        plotData["height"] = record.bounds.h;
+        plotData["crop"] = record.crop;
+        plotData["cropIndex"] = record.cropIndex;
+        plotData["deviation"] = record.deviation;
+
+        // add to list
+        plots.append(plotData);
+    }
+
+    // asign list as a field
+    farmData["plots"] = plots;
+
+    // serialize to text first, so the plot positions in it can be found for the index
+    Json::StreamWriterBuilder builder;
+    std::string text = Json::writeString(builder, farmData);
+
+    std::vector<PlotSpan> spans;
+    int arrayBegin, arrayEnd;
+    FarmFile::scanPlots(text, &spans, &arrayBegin, &arrayEnd);
+
+    // serialize into a temporary file next to the real one
+    std::string tmpname = filename + ".tmp";
+    std::ofstream file(tmpname, std::ofstream::binary);
+    if (!file.good()) {
+        printf("ERROR: UNABLE TO OPEN %s FOR WRITING\n", tmpname.c_str());
+        return false;
+    }
+
+    file.write(text.data(), text.size());
+    file.close();
+
+    // a short write, like on a full disk, must never replace the good file
+    if (!file.good()) {
+        printf("ERROR: UNABLE TO WRITE %s\n", tmpname.c_str());
+        std::error_code ignored;
+        std::filesystem::remove(tmpname, ignored);
+        return false;
+    }
+
+    // swap it in place of the old file
+    std::error_code error;
+    std::filesystem::rename(tmpname, filename, error);
+    if (error) {
+        printf("ERROR: UNABLE TO REPLACE %s\n", filename.c_str());
+        printf("ERROR MESSAGE: %s\n", error.message().c_str());
+        return false;
+    }
+
+    return FarmFile::writeIndex(filename, farmName, records, spans);
+}
+
+// reads the whole file in one go
+bool FarmFile::readAll(std::string filename, std::string* buffer) {
+    std::ifstream file(filename, std::ifstream::binary);
+    if (!file.good()) {
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    buffer->resize(file.tellg());
+    file.seekg(0, std::ios::beg);
+    file.read(&(*buffer)[0], buffer->size());
+
+    return true;
+}
+
+// walks the text once, only looking at quotes and brackets
+// this is a lot cheaper than building json values, and gives the boundaries needed to split the work
+bool FarmFile::scanPlots(const std::string& buffer, std::vector<PlotSpan>* spans, int* arrayBegin, int* arrayEnd) {
+    const char* text = buffer.data();
+    int size = buffer.size();
+    int depth = 0;
+
+    // last string seen at depth 1, this is the key when followed by a colon
+    int keyBegin = -1;
+    int keyEnd = -1;
+    bool inPlots = false;
+    int elementBegin = -1;
+
+    *arrayBegin = -1;
+    *arrayEnd = -1;
+
+    for (int i = 0; i < size; i++) {
+        char c = text[i];
+
+        if (c == '"') {
+            // skip to the closing quote, stepping over escapes
+            int start = i + 1;
+            i++;
+            while (i < size && text[i] != '"') {
+                if (text[i] == '\\') {
+                    i++;
+                }
+                i++;
+            }
+
+            if (depth == 1) {
+                keyBegin = start;
+                keyEnd = i;
+            }
+        } else if (c == '{' || c == '[') {
+            depth++;
+
+            // the value after the "plots" key
+            if (depth == 2 && c == '[' && keyBegin >= 0 && buffer.compare(keyBegin, keyEnd - keyBegin, "plots") == 0) {
+                inPlots = true;
+                *arrayBegin = i;
+            } else if (inPlots && depth == 3) {
+                elementBegin = i;
+            }
+        } else if (c == '}' || c == ']') {
+            if (inPlots && depth == 3) {
+                spans->push_back((PlotSpan){elementBegin, i + 1});
+            } else if (inPlots && depth == 2) {
+                inPlots = false;
+                *arrayEnd = i;
+            }
+
+            depth--;
+            if (depth < 0) {
+                return false;
+            }
+        } else if (c == ',' && depth == 1) {
+            keyBegin = -1;
+        }
+    }
+
+    // a missing plots array is fine, unbalanced brackets are not
+    return depth == 0;
+}
+
+// creates a plot from one element of the plots array
+Plot* FarmFile::plotFromJson(Json::Value& data, CropRegistry* registry) {
+    // bounding box infomation
+    int x = data["x"].asInt();
+    int y = data["y"].asInt();
+    int w = data["width"].asInt();
+    int h = data["height"].asInt();
+
+    // plot/crop information
+    std::string name = data["name"].asString();
+    std::string crop = data["crop"].asString();
+    double deviation = data["deviation"].asDouble();
+
+    // fall back to no crop if the crop isnt in the registry anymore
+    CropRegistry::CropEntry* entry = registry->access(crop);
+    if (entry == nullptr) {
+        entry = registry->access("NO SELECTION");
+    }
+
+    // the saved crop index is ignored, the crop's place in the table can change between runs
+    return new Plot(x, y, w, h, name, entry->index, deviation, entry);
+}
+
+bool FarmFile::load(const std::string& buffer, CropRegistry* registry, std::string* farmName, std::vector<Plot*>* plots, std::vector<PlotSpan>* spanOut) {
+    // find the plot objects first
+    std::vector<PlotSpan> localSpans;
+    std::vector<PlotSpan>& spans = spanOut ? *spanOut : localSpans;
+    int arrayBegin, arrayEnd;
+    spans.clear();
+    if (!FarmFile::scanPlots(buffer, &spans, &arrayBegin, &arrayEnd)) {
+        printf("ERROR: FARM FILE IS NOT VALID JSON\n");
+        return false;
+    }
+
+    // everything outside the plot array is tiny, so it is parsed normally with an empty array in its place
+    std::string header = buffer;
+    if (arrayBegin >= 0 && arrayEnd >= 0) {
+        header = buffer.substr(0, arrayBegin + 1) + buffer.substr(arrayEnd);
+    }
+
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    Json::Value dst;
+    if (!reader->parse(header.data(), header.data() + header.size(), &dst, nullptr)) {
+        printf("ERROR: FARM FILE IS NOT VALID JSON\n");
+        return false;
+    }
+
+    *farmName = dst["name"].asString();
+
+    // every plot gets its slot up front, so workers write straight into place
+    int count = spans.size();
+    plots->assign(count, nullptr);
+    std::atomic<bool> failed(false);
+
+    Parallel::forRange(count, PARALLEL_BLOCK, [&](int begin, int end) {
+        // readers arent thread safe, so every block gets its own
+        std::unique_ptr<Json::CharReader> blockReader(builder.newCharReader());
+        Json::Value data;
+
+        for (int i = begin; i < end; i++) {
+            const char* text = buffer.data();
+            if (!blockReader->parse(text + spans[i].begin, text + spans[i].end, &data, nullptr)) {
+                failed = true;
+                continue;
+            }
+
+            Plot* plot = FarmFile::plotFromJson(data, registry);
+            plot->id = i;
+            (*plots)[i] = plot;
+        }
+    });
+
+    if (failed) {
+        printf("ERROR: FARM FILE CONTAINS INVALID PLOTS\n");
+        for (auto& plot : *plots) {
+            delete plot;
+        }
+        plots->clear();
+        return false;
+    }
+
+    return true;
+}
+
+std::string FarmFile::indexName(std::string filename) {
+    return filename + ".idx";
+}
+
+bool FarmFile::writeIndex(std::string filename, std::string farmName, std::vector<PlotRecord>& records, std::vector<PlotSpan>& spans) {
+    // the index is only useful if it lines up with the json exactly
+    int64_t jsonSize, jsonTime;
+    if (spans.size() != records.size() || !jsonStamp(filename, &jsonSize, &jsonTime)) {
+        return false;
+    }
+
+    // crop names are stored once and referenced by position
+    std::vector<std::string> cropNames;
+    std::unordered_map<std::string, int> cropLookup;
+    std::vector<IndexRecord> entries(records.size());
+
+    for (int i = 0; i < (int) records.size(); i++) {
+        PlotRecord& record = records[i];
+        auto found = cropLookup.find(record.crop);
+        int crop;
+
+        if (found == cropLookup.end()) {
+            crop = cropNames.size();
+            cropLookup[record.crop] = crop;
+            cropNames.push_back(record.crop);
+        } else {
+            crop = found->second;
+        }
+
+        entries[i] = (IndexRecord){record.bounds.x, record.bounds.y, record.bounds.w, record.bounds.h,
+            crop, record.cropIndex, spans[i].begin, spans[i].end};
+    }
+
+    std::string tmpname = FarmFile::indexName(filename) + ".tmp";
+    std::ofstream file(tmpname, std::ofstream::binary);
+    if (!file.good()) {
+        return false;
+    }
+
+    // header
+    uint32_t magic = FARM_INDEX_MAGIC;
+    uint32_t version = FARM_INDEX_VERSION;
+    uint32_t cropCount = cropNames.size();
+    uint32_t plotCount = entries.size();
+    file.write((char*) &magic, sizeof(magic));
+    file.write((char*) &version, sizeof(version));
+    file.write((char*) &jsonSize, sizeof(jsonSize));
+    file.write((char*) &jsonTime, sizeof(jsonTime));
+    writeString(file, farmName);
+
+    // crop table then every plot in one block
+    file.write((char*) &cropCount, sizeof(cropCount));
+    for (auto& name : cropNames) {
+        writeString(file, name);
+    }
+
+    file.write((char*) &plotCount, sizeof(plotCount));
+    file.write((char*) entries.data(), entries.size() * sizeof(IndexRecord));
+    file.close();
+
+    std::error_code error;
+    std::filesystem::rename(tmpname, FarmFile::indexName(filename), error);
+    return !error;
+}
+
+bool FarmFile::loadIndex(std::string filename, CropRegistry* registry, std::string* farmName, std::vector<Plot*>* plots, std::vector<PlotSpan>* spans) {
+    std::ifstream file(FarmFile::indexName(filename), std::ifstream::binary);
+    if (!file.good()) {
+        return false;
+    }
+
+    // make sure this index belongs to the json as it is now
+    uint32_t magic = 0, version = 0;
+    int64_t indexSize = 0, indexTime = 0, jsonSize, jsonTime;
+    file.read((char*) &magic, sizeof(magic));
+    file.read((char*) &version, sizeof(version));
+    file.read((char*) &indexSize, sizeof(indexSize));
+    file.read((char*) &indexTime, sizeof(indexTime));
+
+    if (magic != FARM_INDEX_MAGIC || version != FARM_INDEX_VERSION || !jsonStamp(filename, &jsonSize, &jsonTime) ||
+        indexSize != jsonSize || indexTime != jsonTime) {
+        return false;
+    }
+
+    if (!readString(file, farmName)) {
+        return false;
+    }
+
+    // look every crop up once, crops that are gone fall back to no selection
+    uint32_t cropCount = 0;
+    file.read((char*) &cropCount, sizeof(cropCount));
+    std::vector<CropRegistry::CropEntry*> crops(cropCount);
+    CropRegistry::CropEntry* none = registry->access("NO SELECTION");
+
+    for (auto& crop : crops) {
+        std::string name;
+        if (!readString(file, &name)) {
+            return false;
+        }
+
+        crop = registry->access(name);
+        if (crop == nullptr) {
+            crop = none;
+        }
+    }
+
+    uint32_t plotCount = 0;
+    file.read((char*) &plotCount, sizeof(plotCount));
+    std::vector<IndexRecord> entries(plotCount);
+    file.read((char*) entries.data(), entries.size() * sizeof(IndexRecord));
+    if (!file.good()) {
+        return false;
+    }
+
+    // build the plots, names and deviations are filled in later by a DetailLoader
+    plots->assign(plotCount, nullptr);
+    spans->resize(plotCount);
+
+    Parallel::forRange(plotCount, PARALLEL_BLOCK, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            IndexRecord& entry = entries[i];
+            bool known = entry.crop >= 0 && entry.crop < (int) cropCount && crops[entry.crop] != none;
+            CropRegistry::CropEntry* crop = known ? crops[entry.crop] : none;
+
+            Plot* plot = new Plot(entry.x, entry.y, entry.w, entry.h, "", crop->index, 0.0, crop);
+            plot->id = i;
+            plot->details = PLOT_DETAILS_PENDING;
+            (*plots)[i] = plot;
+            (*spans)[i] = (PlotSpan){entry.begin, entry.end};
+        }
+    });
+
+    return true;
+}
@@ -0,0 +1,58 @@
+/*
+ *  grid.cpp - bucketing plots by where they are, for finding the ones near each other
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+void PlotGrid::build(const std::vector<Plot*>& plots, int margin) {
+    int count = plots.size();
+    this->extent = {0, 0, 0, 0};
+    this->cell = PLOT_MIN_WIDTH;
+    this->columns = 1;
+    this->rows = 1;
+    this->starts.assign(2, 0);
+    this->ids.clear();
+    if (count == 0) {
+        return;
+    }
+
+    // cells about the size of an average plot, doubled until there are only a few per plot
+    this->extent = plots[0]->bounds;
+    int64_t sizes = 0;
+    for (auto& plot : plots) {
+        SDL_UnionRect(&this->extent, &plot->bounds, &this->extent);
+        sizes += plot->bounds.w + plot->bounds.h;
+    }
+    this->cell = std::max((int) (sizes / (2 * count)), PLOT_MIN_WIDTH);
+    while ((int64_t) (this->extent.w / this->cell + 1) * (this->extent.h / this->cell + 1) > 4 * (int64_t) count + 1024) {
+        this->cell *= 2;
+    }
+    this->columns = this->extent.w / this->cell + 1;
+    this->rows = this->extent.h / this->cell + 1;
+
+    auto grown = [&](Plot* plot) {
+        SDL_Rect bounds = plot->bounds;
+        return SDL_Rect{bounds.x - margin, bounds.y - margin, bounds.w + margin * 2, bounds.h + margin * 2};
+    };
+
+    // counted first, then a prefix sum gives every cell its start and the ids are filled in
+    int cells = this->columns * this->rows;
+    this->starts.assign(cells + 1, 0);
+    for (auto& plot : plots) {
+        this->forCells(grown(plot), [&](int at) { this->starts[at + 1]++; });
+    }
+    for (int at = 0; at < cells; at++) {
+        this->starts[at + 1] += this->starts[at];
+    }
+
+    this->ids.resize(this->starts.back());
+    std::vector<int> filled(this->starts.begin(), this->starts.end() - 1);
+    for (auto& plot : plots) {
+        this->forCells(grown(plot), [&](int at) { this->ids[filled[at]++] = plot->id; });
+    }
+}
+
+int PlotGrid::cellOf(int x, int y) {
+    return ((y - this->extent.y) / this->cell) * this->columns + (x - this->extent.x) / this->cell;
+}
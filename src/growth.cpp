@@ -0,0 +1,391 @@
+/*
+ *  growth.cpp - day by day growth of every plot over a season
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// share of a crop's growth where it stops being a seedling, and where it starts ripening
+#define GROWTH_SEEDLING_END 0.2f
+#define GROWTH_RIPENING_START 0.75f
+
+// first planting day of plots that never get planted, and harvest day of plantings the season ended on
+#define GROWTH_NEVER 255
+
+// colors the stages are shown in, on the canvas and in the timeline
+static const SDL_Color stageColors[GROWTH_STAGES] = {
+    {110, 85, 60, 150},
+    {170, 230, 110, 150},
+    {40, 160, 50, 150},
+    {235, 185, 30, 170},
+    {150, 130, 110, 150}
+};
+
+static const char* stageNames[GROWTH_STAGES] = {"Fallow", "Seedling", "Growing", "Ripening", "Harvested"};
+
+GrowthSimulation::GrowthSimulation() {
+    this->open = false;
+    this->day = 0;
+    this->overlay = true;
+    this->plots = 0;
+    this->seconds = 0.0f;
+    this->hasResult = false;
+    this->cancelled = false;
+    this->finished = false;
+    this->progress = 0;
+    this->blocks = 1;
+    this->stagesDay = -1;
+    memset(this->harvestCurve, 0, sizeof(this->harvestCurve));
+
+    // cool at both ends of the season and fastest in the middle, a little under normal on average
+    this->grown[0] = 0.0f;
+    for (int day = 0; day < GROWTH_SEASON_DAYS; day++) {
+        this->weather[day] = 0.6f + 0.6f * sin(M_PI * (day + 0.5) / GROWTH_SEASON_DAYS);
+        this->grown[day + 1] = this->grown[day] + this->weather[day];
+    }
+}
+
+GrowthSimulation::~GrowthSimulation() {
+    this->cancelled = true;
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+}
+
+void GrowthSimulation::reset() {
+    if (this->worker.joinable()) {
+        this->cancelled = true;
+        this->worker.join();
+    }
+
+    this->hasResult = false;
+    this->stagesDay = -1;
+}
+
+void GrowthSimulation::snapshot(Farm* farm) {
+    int count = farm->plots.size();
+    this->rates.resize(count);
+    this->harvests.resize(count);
+    this->firstDays.resize(count);
+
+    for (auto& plot : farm->plots) {
+        plot->syncCrop();
+        CropRegistry::CropEntry* crop = plot->crop;
+
+        // plots of one crop go in over a couple of weeks instead of all on the same day
+        float rate = 1.0f / crop->growthDays;
+        int first = crop->plantingDay + plot->id % GROWTH_STAGGER_DAYS;
+
+        // empty plots, and crops that couldnt ripen before the season ends, are never planted
+        bool fits = crop->index != 0 && first < GROWTH_SEASON_DAYS && (this->grown[GROWTH_SEASON_DAYS] - this->grown[first]) * rate >= 1.0f;
+
+        this->rates[plot->id] = rate;
+        this->harvests[plot->id] = plot->expectedHarvest();
+        this->firstDays[plot->id] = fits ? first : GROWTH_NEVER;
+    }
+
+    // the progress bar divides by this while the worker runs, so it is worked out before it starts
+    this->blocks = std::max(1, (count + GROWTH_PLOT_BLOCK - 1) / GROWTH_PLOT_BLOCK);
+}
+
+void GrowthSimulation::start(Farm* farm) {
+    if (this->running()) {
+        return;
+    }
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+
+    this->snapshot(farm);
+    this->cancelled = false;
+    this->finished = false;
+    this->progress = 0;
+    this->worker = std::thread([this]() {
+        this->simulate();
+        this->finished = true;
+    });
+}
+
+bool GrowthSimulation::running() {
+    return this->worker.joinable() && !this->finished;
+}
+
+void GrowthSimulation::simulateBlock(int begin, int end, Day* days, float* bases, int* next, int* planted, int* count) {
+    int size = end - begin;
+    const float* rates = &this->rates[begin];
+    const float* harvests = &this->harvests[begin];
+
+    // a plot's base is the season's summed weather on the day it was planted, under 0 means nothing is growing
+    for (int i = 0; i < size; i++) {
+        bases[i] = -1.0f;
+        next[i] = this->firstDays[begin + i];
+        planted[i] = 0;
+        count[i] = 0;
+    }
+
+    for (int day = 0; day < GROWTH_SEASON_DAYS; day++) {
+        float before = this->grown[day];
+        float after = this->grown[day + 1];
+        int sown = 0;
+        int growing = 0;
+        int ripening = 0;
+        int ready = 0;
+        int resting = 0;
+
+        // no branches and nothing but flat arrays, so this turns into vector code
+        // growth is worked out the same way stageOf does it, so looked up stages always agree with these counts
+        for (int i = 0; i < size; i++) {
+            bool planting = next[i] == day;
+            float base = planting ? before : bases[i];
+            planted[i] = planting ? day : planted[i];
+            bases[i] = base;
+            float p = base >= 0.0f ? (after - base) * rates[i] : -1.0f;
+
+            sown += p >= 0.0f;
+            growing += p >= GROWTH_SEEDLING_END;
+            ripening += p >= GROWTH_RIPENING_START;
+            ready += p >= 1.0f;
+            resting += (p < 0.0f) & (count[i] > 0);
+        }
+
+        Day& totals = days[day];
+        totals.stages[GROWTH_STAGE_FALLOW] += size - sown - resting;
+        totals.stages[GROWTH_STAGE_SEEDLING] += sown - growing;
+        totals.stages[GROWTH_STAGE_GROWING] += growing - ripening;
+        totals.stages[GROWTH_STAGE_RIPENING] += ripening;
+        totals.stages[GROWTH_STAGE_HARVESTED] += resting;
+
+        if (ready == 0) {
+            continue;
+        }
+
+        // ripe plots are harvested at the end of the day, and sown again the next morning
+        // if there is still time for another crop to ripen
+        for (int i = 0; i < size; i++) {
+            if (bases[i] < 0.0f || (after - bases[i]) * rates[i] < 1.0f) {
+                continue;
+            }
+
+            int slot = (begin + i) * GROWTH_MAX_PLANTINGS + count[i];
+            this->plantDays[slot] = planted[i];
+            this->harvestDays[slot] = day;
+            count[i]++;
+            totals.harvested += harvests[i];
+            bases[i] = -1.0f;
+
+            bool fits = count[i] < GROWTH_MAX_PLANTINGS && day + 1 < GROWTH_SEASON_DAYS &&
+                (this->grown[GROWTH_SEASON_DAYS] - after) * rates[i] >= 1.0f;
+            next[i] = fits ? day + 1 : GROWTH_NEVER;
+        }
+    }
+
+    // plantings still in the ground when the season ended
+    for (int i = 0; i < size; i++) {
+        if (bases[i] >= 0.0f) {
+            int slot = (begin + i) * GROWTH_MAX_PLANTINGS + count[i];
+            this->plantDays[slot] = planted[i];
+            this->harvestDays[slot] = GROWTH_NEVER;
+            count[i]++;
+        }
+        this->plantings[begin + i] = count[i];
+    }
+}
+
+float GrowthSimulation::simulate() {
+    auto start = std::chrono::steady_clock::now();
+
+    int count = this->rates.size();
+    this->plots = count;
+
+    this->plantDays.assign((size_t) count * GROWTH_MAX_PLANTINGS, 0);
+    this->harvestDays.assign((size_t) count * GROWTH_MAX_PLANTINGS, GROWTH_NEVER);
+    this->plantings.assign(count, 0);
+
+    // state of the plots while they are stepped, only needed during the run
+    std::vector<float> bases(count);
+    std::vector<int> next(count);
+    std::vector<int> planted(count);
+    std::vector<int> done(count);
+
+    // each block runs through the whole season on its own, its plots stay in cache the whole way
+    // and every block keeps its own daily totals, which are added up in block order afterwards
+    std::vector<Day> partials((size_t) this->blocks * GROWTH_SEASON_DAYS, Day{});
+    Parallel::forRange(count, GROWTH_PLOT_BLOCK, [&](int begin, int end) {
+        if (this->cancelled) {
+            return;
+        }
+
+        Day* days = &partials[(size_t) (begin / GROWTH_PLOT_BLOCK) * GROWTH_SEASON_DAYS];
+        this->simulateBlock(begin, end, days, &bases[begin], &next[begin], &planted[begin], &done[begin]);
+        this->progress++;
+    });
+
+    this->days.assign(GROWTH_SEASON_DAYS, Day{});
+    for (int block = 0; block < this->blocks; block++) {
+        for (int day = 0; day < GROWTH_SEASON_DAYS; day++) {
+            Day& from = partials[(size_t) block * GROWTH_SEASON_DAYS + day];
+            Day& to = this->days[day];
+            for (int stage = 0; stage < GROWTH_STAGES; stage++) {
+                to.stages[stage] += from.stages[stage];
+            }
+            to.harvested += from.harvested;
+        }
+    }
+
+    for (int day = 0; day < GROWTH_SEASON_DAYS; day++) {
+        this->harvestCurve[day] = this->days[day].harvested;
+    }
+
+    this->stagesDay = -1;
+    this->seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    return this->seconds;
+}
+
+int GrowthSimulation::stageOf(int id, int day) {
+    int stage = GROWTH_STAGE_FALLOW;
+
+    for (int planting = 0; planting < this->plantings[id]; planting++) {
+        int slot = id * GROWTH_MAX_PLANTINGS + planting;
+        if (this->plantDays[slot] > day) {
+            break;
+        }
+
+        // growth so far comes straight from the summed weather, without stepping through the days
+        if (day <= this->harvestDays[slot]) {
+            float grown = (this->grown[day + 1] - this->grown[this->plantDays[slot]]) * this->rates[id];
+            if (grown >= GROWTH_RIPENING_START) {
+                return GROWTH_STAGE_RIPENING;
+            }
+            return grown >= GROWTH_SEEDLING_END ? GROWTH_STAGE_GROWING : GROWTH_STAGE_SEEDLING;
+        }
+
+        stage = GROWTH_STAGE_HARVESTED;
+    }
+
+    return stage;
+}
+
+GrowthSimulation::Day& GrowthSimulation::totalsOn(int day) {
+    return this->days[day];
+}
+
+double GrowthSimulation::harvestedBy(int day) {
+    double total = 0.0;
+    for (int i = 0; i <= day && i < (int) this->days.size(); i++) {
+        total += this->days[i].harvested;
+    }
+    return total;
+}
+
+void GrowthSimulation::updateStages() {
+    this->stages.resize(this->plots);
+    int day = this->day;
+
+    Parallel::forRange(this->plots, GROWTH_PLOT_BLOCK, [&](int begin, int end) {
+        for (int id = begin; id < end; id++) {
+            this->stages[id] = this->stageOf(id, day);
+        }
+    });
+
+    this->stagesDay = day;
+}
+
+void GrowthSimulation::render(SDL_Renderer* renderer, Farm* farm) {
+    if (!this->overlay || !this->hasResult || this->running()) {
+        return;
+    }
+
+    if (this->stagesDay != this->day) {
+        this->updateStages();
+    }
+
+    // plots added since the run have nothing to show
+    for (auto& rects : this->stageRects) {
+        rects.clear();
+    }
+    int count = std::min(this->plots, (int) farm->plots.size());
+    for (int id = 0; id < count; id++) {
+        this->stageRects[this->stages[id]].push_back(farm->plots[id]->bounds);
+    }
+
+    // one call per stage instead of one per plot
+    SDL_BlendMode mode;
+    SDL_GetRenderDrawBlendMode(renderer, &mode);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    for (int stage = 0; stage < GROWTH_STAGES; stage++) {
+        std::vector<SDL_Rect>& rects = this->stageRects[stage];
+        if (!rects.empty()) {
+            SDL_Color color = stageColors[stage];
+            SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+            SDL_RenderFillRects(renderer, rects.data(), rects.size());
+        }
+    }
+    SDL_SetRenderDrawBlendMode(renderer, mode);
+}
+
+void GrowthSimulation::show(Farm* farm) {
+    ImGui::SetNextWindowSize(ImVec2(440, 400), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Growth Simulation", &this->open)) {
+        ImGui::End();
+        return;
+    }
+
+    // the finished worker is picked up here, a cancelled run has nothing worth showing
+    if (this->finished && this->worker.joinable()) {
+        this->worker.join();
+        this->hasResult = !this->cancelled;
+    }
+
+    bool busy = this->running();
+
+    ImGui::BeginDisabled(busy);
+    if (ImGui::Button("Run Season")) {
+        this->start(farm);
+    }
+    ImGui::EndDisabled();
+
+    if (busy) {
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            this->cancelled = true;
+        }
+        ImGui::SameLine();
+        ImGui::ProgressBar((float) this->progress / this->blocks);
+    }
+
+    if (this->hasResult && !busy) {
+        ImGui::SameLine();
+        ImGui::Checkbox("Show On Canvas", &this->overlay);
+
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        ImGui::SliderInt("##day", &this->day, 0, GROWTH_SEASON_DAYS - 1, "Day %d");
+
+        // harvests over the season, with the timeline's day marked
+        ImVec2 size = ImVec2(ImGui::GetContentRegionAvail().x, 80);
+        ImGui::PlotHistogram("##harvests", this->harvestCurve, GROWTH_SEASON_DAYS, 0, nullptr, 0.0f, FLT_MAX, size);
+        ImVec2 low = ImGui::GetItemRectMin();
+        ImVec2 high = ImGui::GetItemRectMax();
+        float x = low.x + (this->day + 0.5f) / GROWTH_SEASON_DAYS * (high.x - low.x);
+        ImGui::GetWindowDrawList()->AddLine(ImVec2(x, low.y), ImVec2(x, high.y), IM_COL32(255, 255, 255, 200));
+
+        Day& today = this->totalsOn(this->day);
+        ImGui::SeparatorText("Plots");
+        for (int stage = 0; stage < GROWTH_STAGES; stage++) {
+            SDL_Color color = stageColors[stage];
+            ImGui::ColorButton(stageNames[stage], ImVec4(color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, 1.0f),
+                ImGuiColorEditFlags_NoTooltip, ImVec2(ImGui::GetTextLineHeight(), ImGui::GetTextLineHeight()));
+            ImGui::SameLine();
+            ImGui::Text("%s: %d", stageNames[stage], today.stages[stage]);
+        }
+
+        ImGui::SeparatorText("Harvest");
+        ImGui::Text("Today: %.1f lbs", today.harvested);
+        ImGui::Text("So Far: %.1f lbs", this->harvestedBy(this->day));
+
+        double plotDays = (double) this->plots * GROWTH_SEASON_DAYS;
+        ImGui::TextDisabled("%d plots over %d days in %.2f s, %.1fM plot days/s", this->plots, GROWTH_SEASON_DAYS, this->seconds,
+            plotDays / std::max(this->seconds, 1e-6f) / 1e6);
+    }
+
+    ImGui::End();
+}
@@ -0,0 +1,284 @@
+/*
+ *  headless.cpp - command line tools for checking, summing up and converting farms
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+static void usage() {
+    printf("usage: main --headless [--crops <crop.csv>] <command> <files...>\n");
+    printf("  validate <farm.json...>       overlapping plots and plots with no area, exits with 1 if any farm has some\n");
+    printf("  stats <farm.json...>          plots, plants and expected harvest of every farm, overall and by crop\n");
+    printf("  convert <in.json> <out.json>  writes the farm out again with its index next to it\n");
+    printf("  index <farm.json...>          writes the index next to every farm so the app opens them faster\n");
+    printf("crops are read from crop.csv in the working directory like the app, unless --crops names another table\n");
+}
+
+static void deletePlots(std::vector<Plot*>& plots) {
+    for (auto& plot : plots) {
+        delete plot;
+    }
+    plots.clear();
+}
+
+int Headless::run(int argc, char** argv) {
+    // --crops can go anywhere after --headless, everything else is the command and its files
+    std::string cropFile = "crop.csv";
+    std::vector<std::string> args;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--crops") == 0 && i + 1 < argc) {
+            cropFile = argv[++i];
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (args.size() < 2) {
+        usage();
+        return 1;
+    }
+
+    std::string command = args[0];
+    std::vector<std::string> files(args.begin() + 1, args.end());
+    if (command != "validate" && command != "stats" && command != "index" && !(command == "convert" && files.size() == 2)) {
+        usage();
+        return 1;
+    }
+
+    // the registry destructor is private, the table is left for the os to clean up like in the app
+    CropRegistry* registry = new CropRegistry();
+    if (!Headless::loadCrops(cropFile, registry)) {
+        return 1;
+    }
+
+    if (command == "validate") {
+        return Headless::validate(files, registry);
+    } else if (command == "stats") {
+        return Headless::stats(files, registry);
+    } else if (command == "convert" && files.size() == 2) {
+        return Headless::convert(files[0], files[1], registry);
+    } else if (command == "index") {
+        return Headless::index(files, registry);
+    }
+
+    return 1;
+}
+
+bool Headless::loadCrops(std::string filename, CropRegistry* registry) {
+    // same loaders as the app, but a missing or broken table is reported instead of ending the process
+    std::error_code error;
+    if (!std::filesystem::exists(filename, error)) {
+        printf("ERROR: UNABLE TO OPEN %s\n", filename.c_str());
+        return false;
+    }
+
+    try {
+        if (std::filesystem::file_size(filename, error) > CSV_FAST_THRESHOLD && !error) {
+            return registry->loadFromCSVFast(filename);
+        }
+        registry->loadFromCSV(filename);
+    } catch (std::exception& error) {
+        printf("ERROR: UNABLE TO OPEN %s\n", filename.c_str());
+        printf("ERROR MESSAGE: %s\n", error.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool Headless::load(std::string filename, CropRegistry* registry, std::string* farmName, std::vector<Plot*>* plots, std::vector<PlotSpan>* spans) {
+    // the index would leave names and deviations to a background loader, every command here wants them
+    std::string buffer;
+    if (!FarmFile::readAll(filename, &buffer)) {
+        printf("ERROR: UNABLE TO OPEN %s\n", filename.c_str());
+        return false;
+    }
+
+    return FarmFile::load(buffer, registry, farmName, plots, spans);
+}
+
+int64_t Headless::overlaps(std::vector<Plot*>& plots, std::vector<std::pair<int, int>>* listed) {
+    int count = plots.size();
+    if (count == 0) {
+        return 0;
+    }
+
+    PlotGrid grid;
+    grid.build(plots, 0);
+
+    // every block keeps its own findings, they are put together in block order so the listing never changes
+    int blocks = (count + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+    std::vector<int64_t> counts(blocks, 0);
+    std::vector<std::vector<std::pair<int, int>>> found(blocks);
+
+    Parallel::forRange(count, PARALLEL_BLOCK, [&](int begin, int end) {
+        int block = begin / PARALLEL_BLOCK;
+        for (int id = begin; id < end; id++) {
+            SDL_Rect* bounds = &plots[id]->bounds;
+
+            // a pair shares every cell their overlap touches, it only counts in the one holding the overlap's corner
+            grid.forCells(*bounds, [&](int at) {
+                for (int i = grid.starts[at]; i < grid.starts[at + 1]; i++) {
+                    int other = grid.ids[i];
+                    SDL_Rect overlap;
+                    if (other <= id || !SDL_IntersectRect(bounds, &plots[other]->bounds, &overlap) || grid.cellOf(overlap.x, overlap.y) != at) {
+                        continue;
+                    }
+
+                    counts[block]++;
+                    if ((int) found[block].size() < HEADLESS_MAX_LISTED) {
+                        found[block].push_back({id, other});
+                    }
+                }
+            });
+        }
+    });
+
+    int64_t total = 0;
+    for (int block = 0; block < blocks; block++) {
+        total += counts[block];
+        for (auto& pair : found[block]) {
+            if ((int) listed->size() < HEADLESS_MAX_LISTED) {
+                listed->push_back(pair);
+            }
+        }
+    }
+    return total;
+}
+
+int Headless::validate(std::vector<std::string>& files, CropRegistry* registry) {
+    int failed = 0;
+
+    for (auto& filename : files) {
+        std::string farmName;
+        std::vector<Plot*> plots;
+        if (!Headless::load(filename, registry, &farmName, &plots, nullptr)) {
+            printf("%s: could not be loaded\n", filename.c_str());
+            failed++;
+            continue;
+        }
+
+        std::vector<std::pair<int, int>> listed;
+        int64_t overlapping = Headless::overlaps(plots, &listed);
+
+        // plots with no area hold nothing and can never be clicked again
+        int64_t empty = 0;
+        for (auto& plot : plots) {
+            if (plot->bounds.w <= 0 || plot->bounds.h <= 0) {
+                if (++empty <= HEADLESS_MAX_LISTED) {
+                    printf("  plot %d \"%s\" is %dx%d\n", plot->id, plot->plotName, plot->bounds.w, plot->bounds.h);
+                }
+            }
+        }
+
+        for (auto& [a, b] : listed) {
+            printf("  plot %d \"%s\" overlaps plot %d \"%s\"\n", a, plots[a]->plotName, b, plots[b]->plotName);
+        }
+
+        if (overlapping > 0 || empty > 0) {
+            printf("%s: %lld overlapping pairs, %lld plots with no area\n", filename.c_str(), (long long) overlapping, (long long) empty);
+            failed++;
+        } else {
+            printf("%s: ok, %d plots\n", filename.c_str(), (int) plots.size());
+        }
+
+        deletePlots(plots);
+    }
+
+    if (failed > 0) {
+        printf("ERROR: %d OF %d FARMS FAILED VALIDATION\n", failed, (int) files.size());
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+int Headless::stats(std::vector<std::string>& files, CropRegistry* registry) {
+    int failed = 0;
+    int cropCount = registry->ordered.size();
+    std::vector<FarmStats::Totals> byCrop(cropCount);
+
+    for (auto& filename : files) {
+        std::string farmName;
+        std::vector<Plot*> plots;
+        if (!Headless::load(filename, registry, &farmName, &plots, nullptr)) {
+            failed++;
+            continue;
+        }
+
+        // same fixed point totals as the yield summary, so the numbers match what the app shows
+        FarmStats::Totals total = {};
+        std::fill(byCrop.begin(), byCrop.end(), FarmStats::Totals{});
+        for (auto& plot : plots) {
+            FarmStats::Totals contribution = FarmStats::contributionOf(plot);
+            total.add(contribution, 1);
+            byCrop[plot->crop->index].add(contribution, 1);
+        }
+
+        printf("%s: \"%s\"\n", filename.c_str(), farmName.c_str());
+        printf("  %lld plots, %lld plants, %lld px area\n", (long long) total.plots, (long long) total.plants, (long long) total.area);
+        printf("  expected harvest %.2f lbs, deviation %.2f lbs\n", total.harvestLbs(), total.deviationLbs());
+        for (int crop = 0; crop < cropCount; crop++) {
+            if (byCrop[crop].plots > 0) {
+                printf("  %s: %lld plots, %lld plants, %.2f lbs\n", registry->ordered[crop]->name.c_str(), (long long) byCrop[crop].plots,
+                    (long long) byCrop[crop].plants, byCrop[crop].harvestLbs());
+            }
+        }
+
+        deletePlots(plots);
+    }
+
+    return failed > 0 ? 1 : 0;
+}
+
+int Headless::convert(std::string input, std::string output, CropRegistry* registry) {
+    std::string farmName;
+    std::vector<Plot*> plots;
+    if (!Headless::load(input, registry, &farmName, &plots, nullptr)) {
+        return 1;
+    }
+
+    // written the same way the autosave does, so the output opens from its index straight away
+    std::vector<PlotRecord> records(plots.size());
+    for (int i = 0; i < (int) plots.size(); i++) {
+        plots[i]->toRecord(&records[i]);
+    }
+
+    bool written = FarmFile::write(output, farmName, records);
+    deletePlots(plots);
+    if (!written) {
+        return 1;
+    }
+
+    printf("wrote %s with %d plots\n", output.c_str(), (int) records.size());
+    return 0;
+}
+
+int Headless::index(std::vector<std::string>& files, CropRegistry* registry) {
+    int failed = 0;
+
+    for (auto& filename : files) {
+        std::string farmName;
+        std::vector<Plot*> plots;
+        std::vector<PlotSpan> spans;
+        if (!Headless::load(filename, registry, &farmName, &plots, &spans)) {
+            failed++;
+            continue;
+        }
+
+        // the json is left as it is, the index only points into it
+        std::vector<PlotRecord> records(plots.size());
+        for (int i = 0; i < (int) plots.size(); i++) {
+            plots[i]->toRecord(&records[i]);
+        }
+
+        if (FarmFile::writeIndex(filename, farmName, records, spans)) {
+            printf("wrote %s\n", FarmFile::indexName(filename).c_str());
+        } else {
+            printf("ERROR: UNABLE TO WRITE %s\n", FarmFile::indexName(filename).c_str());
+            failed++;
+        }
+
+        deletePlots(plots);
+    }
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,306 @@
+/*
+ *  heatmap.cpp - plots shaded by yield, deviation or risk instead of crop color
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// standard normal quantile of the 5th percentile, risk is what a plot loses in a bad year
+#define HEATMAP_RISK_Z 1.6448536f
+
+static const char* metricNames[HEATMAP_METRICS] = {"Yield Per Area", "Deviation", "Risk"};
+static const char* metricUnits[HEATMAP_METRICS] = {"lbs per plant spot", "lbs", "lbs lost per plant spot"};
+
+// blue at nothing through green to red at the top of the ramp, as a packed ARGB8888 pixel
+// plots with nothing planted are negative and come out fully transparent
+static void rampScalar(const float* values, uint32_t* colors, int count, float scale) {
+    for (int i = 0; i < count; i++) {
+        float t = std::min(std::max(values[i] * scale, 0.0f), 1.0f);
+        float centered = t * 2.0f - 1.0f;
+        uint32_t red = lrintf(std::max(centered, 0.0f) * 255.0f);
+        uint32_t green = lrintf((1.0f - fabsf(centered)) * 255.0f);
+        uint32_t blue = lrintf(std::max(0.0f - centered, 0.0f) * 255.0f);
+        colors[i] = values[i] >= 0.0f ? 0xFF000000 | red << 16 | green << 8 | blue : 0;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// same ramp 4 plots at a time, the conversions round to nearest just like lrintf
+__attribute__((target("sse2")))
+static void rampSSE2(const float* values, uint32_t* colors, int count, float scale) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 full = _mm_set1_ps(255.0f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 factor = _mm_set1_ps(scale);
+    const __m128i alpha = _mm_set1_epi32(0xFF000000);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 value = _mm_loadu_ps(values + i);
+        __m128 t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(value, factor), zero), one);
+        __m128 centered = _mm_sub_ps(_mm_mul_ps(t, two), one);
+
+        __m128i red = _mm_cvtps_epi32(_mm_mul_ps(_mm_max_ps(centered, zero), full));
+        __m128i green = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, centered)), full));
+        __m128i blue = _mm_cvtps_epi32(_mm_mul_ps(_mm_max_ps(_mm_sub_ps(zero, centered), zero), full));
+
+        __m128i color = _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(red, 16)), _mm_or_si128(_mm_slli_epi32(green, 8), blue));
+        __m128i planted = _mm_castps_si128(_mm_cmpge_ps(value, zero));
+        _mm_storeu_si128((__m128i*) (colors + i), _mm_and_si128(color, planted));
+    }
+
+    rampScalar(values + i, colors + i, count - i, scale);
+}
+#endif
+
+// picks the widest version the cpu supports, once
+typedef void (*RampKernel)(const float*, uint32_t*, int, float);
+
+static RampKernel pickRamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        return rampSSE2;
+    }
+#endif
+    return rampScalar;
+}
+
+static RampKernel ramp = pickRamp();
+
+Heatmap::Heatmap(SDL_Renderer* renderer) {
+    this->open = false;
+    this->metric = HEATMAP_YIELD_PER_AREA;
+    this->opacity = 0.8f;
+    this->renderer = renderer;
+    this->texture = nullptr;
+    this->pixels.assign(WINDOW_WIDTH * WINDOW_HEIGHT, 0);
+    this->highest = 0.0f;
+    this->farm = nullptr;
+    this->farmVersion = 0;
+    this->registryVersion = -1;
+    this->detailsDone = false;
+    this->paintedMetric = -1;
+    this->dirty = {0, 0, 0, 0};
+}
+
+Heatmap::~Heatmap() {
+    if (this->texture) {
+        SDL_DestroyTexture(this->texture);
+    }
+}
+
+void Heatmap::reset() {
+    this->farm = nullptr;
+}
+
+void Heatmap::invalidate() {
+    // the pixels are all still here, they only have to be uploaded again
+    if (this->texture) {
+        SDL_DestroyTexture(this->texture);
+        this->texture = nullptr;
+    }
+}
+
+float Heatmap::scaleTop() {
+    return this->highest;
+}
+
+float Heatmap::valueOf(Plot* plot) {
+    double harvest = plot->expectedHarvest();
+    if (harvest <= 0.0) {
+        return -1.0f;
+    }
+
+    // plots still loading their details count as exact, like the yield totals
+    double deviation = plot->hasDetails() ? harvest * plot->yieldDeviance / 100.0 : 0.0;
+    double spots = std::max(1.0, (double) plot->bounds.w * plot->bounds.h / HEATMAP_AREA_UNIT);
+
+    switch (this->metric) {
+        case HEATMAP_DEVIATION:
+            return deviation;
+        case HEATMAP_RISK:
+            return HEATMAP_RISK_Z * deviation / spots;
+        default:
+            return harvest / spots;
+    }
+}
+
+SDL_Rect Heatmap::paint(SDL_Rect rect, uint32_t color) {
+    SDL_Rect canvas = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    SDL_Rect visible;
+    if (!SDL_IntersectRect(&rect, &canvas, &visible)) {
+        return {0, 0, 0, 0};
+    }
+
+    for (int y = visible.y; y < visible.y + visible.h; y++) {
+        uint32_t* row = &this->pixels[y * WINDOW_WIDTH + visible.x];
+        std::fill(row, row + visible.w, color);
+    }
+
+    if (SDL_RectEmpty(&this->dirty)) {
+        this->dirty = visible;
+    } else {
+        SDL_UnionRect(&this->dirty, &visible, &this->dirty);
+    }
+    return visible;
+}
+
+void Heatmap::repaint(Farm* farm) {
+    int count = this->values.size();
+    ramp(this->values.data(), this->colors.data(), count, this->highest > 0.0f ? 1.0f / this->highest : 0.0f);
+
+    std::fill(this->pixels.begin(), this->pixels.end(), 0);
+    this->dirty = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    for (int id = 0; id < count; id++) {
+        this->paintedRects[id] = this->paint(farm->plots[id]->bounds, this->colors[id]);
+    }
+}
+
+void Heatmap::refresh(Farm* farm, CropRegistry* registry) {
+    bool detailsDone = farm->detailLoader == nullptr || farm->detailLoader->done();
+
+    // a different farm, reloaded crops, the deviations coming in or another metric touch everything
+    bool full = farm != this->farm || registry->version != this->registryVersion || detailsDone != this->detailsDone ||
+        this->metric != this->paintedMetric;
+
+    this->changed.clear();
+    if (!full && farm->version != this->farmVersion) {
+        // new plots start out unpainted, so adding them is the same as changing them
+        for (int id = this->values.size(); id < (int) farm->plots.size(); id++) {
+            this->values.push_back(-1.0f);
+            this->colors.push_back(0);
+            this->paintedRects.push_back({0, 0, 0, 0});
+            this->changed.push_back(id);
+        }
+
+        farm->changedSince(this->farmVersion, &this->changed);
+    }
+
+    if (full) {
+        int count = farm->plots.size();
+        this->values.resize(count);
+        this->colors.resize(count);
+        this->paintedRects.resize(count);
+
+        Parallel::forRange(count, PARALLEL_BLOCK, [&](int begin, int end) {
+            for (int id = begin; id < end; id++) {
+                farm->plots[id]->syncCrop();
+                this->values[id] = this->valueOf(farm->plots[id]);
+            }
+        });
+
+        this->highest = 0.0f;
+        for (float value : this->values) {
+            this->highest = std::max(this->highest, value);
+        }
+        this->repaint(farm);
+
+        this->farm = farm;
+        this->farmVersion = farm->version;
+        this->registryVersion = registry->version;
+        this->detailsDone = detailsDone;
+        this->paintedMetric = this->metric;
+        return;
+    }
+
+    if (this->changed.empty()) {
+        return;
+    }
+
+    // the whole farm is only looked at again if the plot at the top of the ramp came down
+    float top = this->highest;
+    bool rescan = false;
+    for (int id : this->changed) {
+        float before = this->values[id];
+        this->values[id] = this->valueOf(farm->plots[id]);
+        rescan |= before == this->highest && this->values[id] < this->highest;
+        top = std::max(top, this->values[id]);
+    }
+
+    if (rescan) {
+        top = 0.0f;
+        for (float value : this->values) {
+            top = std::max(top, value);
+        }
+    }
+
+    // every old spot is cleared before any new one goes down, so a plot moving onto where another was isnt wiped
+    for (int id : this->changed) {
+        this->paint(this->paintedRects[id], 0);
+        this->paintedRects[id] = {0, 0, 0, 0};
+    }
+
+    // a new top recolors every plot, but only the ones on screen have pixels to redo
+    float scale = top > 0.0f ? 1.0f / top : 0.0f;
+    if (top != this->highest) {
+        this->highest = top;
+        ramp(this->values.data(), this->colors.data(), this->values.size(), scale);
+        for (int id = 0; id < (int) this->paintedRects.size(); id++) {
+            if (!SDL_RectEmpty(&this->paintedRects[id])) {
+                this->paint(this->paintedRects[id], this->colors[id]);
+            }
+        }
+    }
+
+    for (int id : this->changed) {
+        ramp(&this->values[id], &this->colors[id], 1, scale);
+        this->paintedRects[id] = this->paint(farm->plots[id]->bounds, this->colors[id]);
+    }
+
+    this->farmVersion = farm->version;
+}
+
+void Heatmap::render(Farm* farm, CropRegistry* registry) {
+    if (this->texture == nullptr) {
+        this->texture = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, WINDOW_WIDTH, WINDOW_HEIGHT);
+        SDL_SetTextureBlendMode(this->texture, SDL_BLENDMODE_BLEND);
+        this->dirty = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    }
+
+    this->refresh(farm, registry);
+
+    // only the pixels that changed are sent to the gpu
+    if (!SDL_RectEmpty(&this->dirty)) {
+        SDL_UpdateTexture(this->texture, &this->dirty, &this->pixels[this->dirty.y * WINDOW_WIDTH + this->dirty.x], WINDOW_WIDTH * sizeof(uint32_t));
+        this->dirty = {0, 0, 0, 0};
+    }
+
+    // opacity is applied when drawing, so changing it never recolors anything
+    SDL_SetTextureAlphaMod(this->texture, (Uint8) (this->opacity * 255.0f));
+    SDL_RenderCopy(this->renderer, this->texture, nullptr, nullptr);
+}
+
+void Heatmap::show() {
+    ImGui::Checkbox("Show Heatmap", &this->open);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+    ImGui::Combo("##heatmap_metric", &this->metric, metricNames, HEATMAP_METRICS);
+
+    if (!this->open) {
+        return;
+    }
+
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+    ImGui::SliderFloat("Opacity", &this->opacity, 0.1f, 1.0f, "%.2f");
+
+    // legend, the same ramp the plots are shaded with
+    ImVec2 corner = ImGui::GetCursorScreenPos();
+    float width = ImGui::GetContentRegionAvail().x * 0.6;
+    float height = ImGui::GetTextLineHeight();
+    ImU32 blue = IM_COL32(0, 0, 255, 255);
+    ImU32 green = IM_COL32(0, 255, 0, 255);
+    ImU32 red = IM_COL32(255, 0, 0, 255);
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilledMultiColor(corner, ImVec2(corner.x + width / 2, corner.y + height), blue, green, green, blue);
+    drawList->AddRectFilledMultiColor(ImVec2(corner.x + width / 2, corner.y), ImVec2(corner.x + width, corner.y + height), green, red, red, green);
+    ImGui::Dummy(ImVec2(width, height));
+
+    ImGui::TextDisabled("0 to %.3g %s", this->highest, metricUnits[this->metric]);
+}
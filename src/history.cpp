@@ -0,0 +1,248 @@
+/*
+ *  history.cpp - undo and redo of plot edits
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+History::History() {
+    this->cursor = 0;
+    this->nextGroup = 0;
+    this->currentGroup = -1;
+    this->bytes = 0;
+    this->limit = HISTORY_MEMORY_LIMIT;
+}
+
+History::~History() {
+    for (auto& edit : this->edits) {
+        History::release(edit);
+    }
+}
+
+void History::recordRect(Plot* plot, SDL_Rect from, SDL_Rect to, bool coalesce) {
+    if (SDL_RectEquals(&from, &to)) {
+        return;
+    }
+
+    // a drag just moves the end point of the edit it started
+    Edit* last = coalesce ? this->openEdit(EDIT_RECT, plot->id) : nullptr;
+    if (last) {
+        last->rect.to = to;
+        return;
+    }
+
+    Edit edit = {};
+    edit.type = EDIT_RECT;
+    edit.open = coalesce;
+    edit.plotId = plot->id;
+    edit.rect.from = from;
+    edit.rect.to = to;
+    this->push(edit);
+}
+
+void History::recordCrop(Plot* plot, CropRegistry::CropEntry* from, int fromIndex, CropRegistry::CropEntry* to, int toIndex) {
+    if (from == to) {
+        return;
+    }
+
+    Edit edit = {};
+    edit.type = EDIT_CROP;
+    edit.plotId = plot->id;
+    edit.crop.from = from;
+    edit.crop.to = to;
+    edit.crop.fromIndex = fromIndex;
+    edit.crop.toIndex = toIndex;
+    this->push(edit);
+}
+
+void History::recordName(Plot* plot, const char* from, const char* to) {
+    // typing keeps replacing the new name of the same edit
+    Edit* last = this->openEdit(EDIT_NAME, plot->id);
+    if (last) {
+        this->bytes -= History::editSize(*last);
+        last->names[1] = to;
+        this->bytes += History::editSize(*last);
+        return;
+    }
+
+    Edit edit = {};
+    edit.type = EDIT_NAME;
+    edit.open = true;
+    edit.plotId = plot->id;
+    edit.names = new std::string[2] {from, to};
+    this->push(edit);
+}
+
+void History::recordDeviation(Plot* plot, float from, float to) {
+    if (from == to) {
+        return;
+    }
+
+    Edit* last = this->openEdit(EDIT_DEVIATION, plot->id);
+    if (last) {
+        last->value.to = to;
+        return;
+    }
+
+    Edit edit = {};
+    edit.type = EDIT_DEVIATION;
+    edit.open = true;
+    edit.plotId = plot->id;
+    edit.value.from = from;
+    edit.value.to = to;
+    this->push(edit);
+}
+
+void History::seal() {
+    if (!this->edits.empty()) {
+        this->edits.back().open = false;
+    }
+}
+
+void History::beginGroup() {
+    this->seal();
+    this->currentGroup = this->nextGroup++;
+}
+
+void History::endGroup() {
+    this->seal();
+    this->currentGroup = -1;
+}
+
+bool History::undo(Farm* farm) {
+    if (this->cursor == 0) {
+        return false;
+    }
+
+    // step back through every edit of the last group
+    int group = this->edits[this->cursor - 1].group;
+    while (this->cursor > 0 && this->edits[this->cursor - 1].group == group) {
+        Edit& edit = this->edits[this->cursor - 1];
+        edit.open = false;
+        this->apply(edit, false, farm);
+        this->cursor--;
+    }
+
+    return true;
+}
+
+bool History::redo(Farm* farm) {
+    if (this->cursor == (int) this->edits.size()) {
+        return false;
+    }
+
+    int group = this->edits[this->cursor].group;
+    while (this->cursor < (int) this->edits.size() && this->edits[this->cursor].group == group) {
+        Edit& edit = this->edits[this->cursor];
+        edit.open = false;
+        this->apply(edit, true, farm);
+        this->cursor++;
+    }
+
+    return true;
+}
+
+bool History::canUndo() {
+    return this->cursor > 0;
+}
+
+bool History::canRedo() {
+    return this->cursor < (int) this->edits.size();
+}
+
+int History::size() {
+    return this->edits.size();
+}
+
+size_t History::memoryUse() {
+    return this->bytes;
+}
+
+void History::setLimit(size_t bytes) {
+    this->limit = bytes;
+}
+
+void History::push(Edit& edit) {
+    // anything that could be redone is gone once something new happens
+    while ((int) this->edits.size() > this->cursor) {
+        this->bytes -= History::editSize(this->edits.back());
+        History::release(this->edits.back());
+        this->edits.pop_back();
+    }
+
+    edit.group = this->currentGroup >= 0 ? this->currentGroup : this->nextGroup++;
+    this->bytes += History::editSize(edit);
+    this->edits.push_back(edit);
+    this->cursor++;
+
+    // drop the oldest groups whole until back under the cap
+    while (this->bytes > this->limit && this->edits.size() > 1) {
+        int group = this->edits.front().group;
+        if (group == edit.group) {
+            break;
+        }
+
+        while (!this->edits.empty() && this->edits.front().group == group) {
+            this->bytes -= History::editSize(this->edits.front());
+            History::release(this->edits.front());
+            this->edits.pop_front();
+            this->cursor--;
+        }
+    }
+}
+
+Edit* History::openEdit(int type, int plotId) {
+    if (this->edits.empty() || this->cursor != (int) this->edits.size()) {
+        return nullptr;
+    }
+
+    Edit& last = this->edits.back();
+    if (last.open && last.type == type && last.plotId == plotId) {
+        return &last;
+    }
+
+    return nullptr;
+}
+
+void History::apply(Edit& edit, bool forward, Farm* farm) {
+    if (edit.plotId < 0 || edit.plotId >= (int) farm->plots.size()) {
+        return;
+    }
+
+    Plot* plot = farm->plots[edit.plotId];
+    farm->requireDetails(plot);
+
+    switch (edit.type) {
+        case EDIT_RECT:
+            plot->bounds = forward ? edit.rect.to : edit.rect.from;
+            break;
+        case EDIT_CROP:
+            plot->updateProperties(forward ? edit.crop.to : edit.crop.from, forward ? edit.crop.toIndex : edit.crop.fromIndex);
+            break;
+        case EDIT_NAME:
+            memset(plot->plotName, 0, sizeof(plot->plotName));
+            strncpy(plot->plotName, edit.names[forward ? 1 : 0].c_str(), sizeof(plot->plotName) - 1);
+            break;
+        case EDIT_DEVIATION:
+            plot->yieldDeviance = forward ? edit.value.to : edit.value.from;
+            break;
+    }
+
+    // undone changes get autosaved like any other
+    farm->markDirty(plot);
+}
+
+size_t History::editSize(Edit& edit) {
+    size_t size = sizeof(Edit);
+
+    if (edit.names) {
+        size += sizeof(std::string) * 2 + edit.names[0].capacity() + edit.names[1].capacity();
+    }
+
+    return size;
+}
+
+void History::release(Edit& edit) {
+    delete[] edit.names;
+    edit.names = nullptr;
+}
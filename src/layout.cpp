@@ -0,0 +1,637 @@
+/*
+ *  layout.cpp - placing and sizing plots to fit the most harvest into a field
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// a chain's first and last temperature, as shares of how much harvest a typical move changes
+#define LAYOUT_HOT 0.3
+#define LAYOUT_COLD 0.001
+
+// moves one edge of a rect out by distance, or in if it is negative
+// edges go left, right, top, bottom
+static SDL_Rect stretch(SDL_Rect rect, int edge, int distance) {
+    switch (edge) {
+        case 0:
+            rect.x -= distance;
+            rect.w += distance;
+            break;
+        case 1:
+            rect.w += distance;
+            break;
+        case 2:
+            rect.y -= distance;
+            rect.h += distance;
+            break;
+        default:
+            rect.h += distance;
+            break;
+    }
+    return rect;
+}
+
+void LayoutOptimizer::Grid::reset(SDL_Rect area, int cell) {
+    this->area = area;
+    this->cell = cell;
+    this->columns = std::max(1, (area.w + cell - 1) / cell);
+    this->rows = std::max(1, (area.h + cell - 1) / cell);
+    this->cells.assign(this->columns * this->rows, std::vector<int>());
+}
+
+// calls fn with every cell rect covers, anything outside the grid's area is left out
+template <typename Fn>
+static void forCells(LayoutOptimizer::Grid& grid, SDL_Rect rect, Fn fn) {
+    int firstX = std::max(0, (rect.x - grid.area.x) / grid.cell);
+    int firstY = std::max(0, (rect.y - grid.area.y) / grid.cell);
+    int lastX = std::min(grid.columns - 1, (rect.x + rect.w - 1 - grid.area.x) / grid.cell);
+    int lastY = std::min(grid.rows - 1, (rect.y + rect.h - 1 - grid.area.y) / grid.cell);
+    if (rect.x + rect.w <= grid.area.x || rect.y + rect.h <= grid.area.y) {
+        return;
+    }
+
+    for (int y = firstY; y <= lastY; y++) {
+        for (int x = firstX; x <= lastX; x++) {
+            fn(grid.cells[y * grid.columns + x]);
+        }
+    }
+}
+
+void LayoutOptimizer::Grid::insert(int id, SDL_Rect rect) {
+    forCells(*this, rect, [&](std::vector<int>& cell) {
+        cell.push_back(id);
+    });
+}
+
+void LayoutOptimizer::Grid::remove(int id, SDL_Rect rect) {
+    forCells(*this, rect, [&](std::vector<int>& cell) {
+        auto found = std::find(cell.begin(), cell.end(), id);
+        if (found != cell.end()) {
+            *found = cell.back();
+            cell.pop_back();
+        }
+    });
+}
+
+bool LayoutOptimizer::Grid::blocked(SDL_Rect rect, int spacing, int ignore, const std::vector<SDL_Rect>& rects) {
+    SDL_Rect around = {rect.x - spacing, rect.y - spacing, rect.w + spacing * 2, rect.h + spacing * 2};
+    bool hit = false;
+
+    forCells(*this, around, [&](std::vector<int>& cell) {
+        for (int i = 0; i < (int) cell.size() && !hit; i++) {
+            hit = cell[i] != ignore && SDL_HasIntersection(&around, &rects[cell[i]]);
+        }
+    });
+
+    return hit;
+}
+
+LayoutOptimizer::LayoutOptimizer() {
+    this->open = false;
+    this->field = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    this->spacing = PLOT_LINE_SPACING;
+    this->sweeps = 500;
+    this->seed = 1;
+    this->changeCrops = true;
+    this->allTargets = 0;
+    this->plots = 0;
+    this->cell = PLOT_MIN_WIDTH;
+    this->startHarvest = 0.0;
+    this->planFarm = nullptr;
+    this->planRegistryVersion = -1;
+    this->finished = false;
+    this->layout = {};
+    this->hasResult = false;
+}
+
+LayoutOptimizer::~LayoutOptimizer() {
+    this->annealing.cancelled = true;
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+}
+
+void LayoutOptimizer::reset() {
+    if (this->worker.joinable()) {
+        this->annealing.cancelled = true;
+        this->worker.join();
+    }
+
+    this->hasResult = false;
+    this->planFarm = nullptr;
+}
+
+void LayoutOptimizer::fitField(Farm* farm) {
+    if (farm->plots.empty()) {
+        this->field = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+        return;
+    }
+
+    this->field = farm->plots[0]->bounds;
+    for (auto& plot : farm->plots) {
+        SDL_UnionRect(&this->field, &plot->bounds, &this->field);
+    }
+}
+
+double LayoutOptimizer::valueOf(int crop, int64_t plants, int64_t area) {
+    double value = this->yields[crop] * (double) plants;
+    int64_t target = this->targetAreas[crop];
+    if (target > 0 && area > target) {
+        value *= (double) target / area;
+    }
+    return value;
+}
+
+void LayoutOptimizer::snapshot(Farm* farm, CropRegistry* registry) {
+    int cropCount = registry->ordered.size();
+    this->plots = farm->plots.size();
+    this->targets.resize(cropCount, 0);
+
+    int64_t fieldArea = (int64_t) this->field.w * this->field.h;
+    this->yields.resize(cropCount);
+    this->spacings.resize(cropCount);
+    this->targetAreas.resize(cropCount);
+    this->candidates.clear();
+    for (int crop = 0; crop < cropCount; crop++) {
+        this->yields[crop] = crop == 0 ? 0.0f : registry->ordered[crop]->avgYield;
+        this->spacings[crop] = registry->ordered[crop]->spacing;
+        this->targetAreas[crop] = fieldArea * this->targets[crop] / 100;
+        if (this->yields[crop] > 0.0f) {
+            this->candidates.push_back(crop);
+        }
+    }
+
+    // the plots first and the obstacles after them, so ids index one list
+    this->startRects.resize(this->plots);
+    this->startCrops.resize(this->plots);
+    for (auto& plot : farm->plots) {
+        plot->syncCrop();
+        this->startRects[plot->id] = plot->bounds;
+        this->startCrops[plot->id] = plot->crop->index;
+    }
+    this->startRects.insert(this->startRects.end(), this->obstacles.begin(), this->obstacles.end());
+
+    // cells about the size of an average plot, fewer if the field is huge
+    int64_t perPlot = fieldArea / std::max(1, this->plots);
+    this->cell = std::max(PLOT_MIN_WIDTH, (int) sqrt((double) perPlot));
+    while ((int64_t) (this->field.w / this->cell + 1) * (this->field.h / this->cell + 1) > LAYOUT_MAX_CELLS) {
+        this->cell *= 2;
+    }
+
+    // plots that already fit where they are stay there to start with, in id order
+    Grid grid;
+    grid.reset(this->field, this->cell);
+    for (int id = this->plots; id < (int) this->startRects.size(); id++) {
+        grid.insert(id, this->startRects[id]);
+    }
+
+    SDL_Rect field = this->field;
+    this->startPlaced.assign(this->plots, 0);
+    std::vector<int64_t> plants(cropCount, 0);
+    std::vector<int64_t> areas(cropCount, 0);
+    for (int id = 0; id < this->plots; id++) {
+        SDL_Rect rect = this->startRects[id];
+        bool inside = rect.x >= field.x && rect.y >= field.y && rect.x + rect.w <= field.x + field.w && rect.y + rect.h <= field.y + field.h;
+        if (inside && rect.w >= PLOT_MIN_WIDTH && rect.h >= PLOT_MIN_HEIGHT && !grid.blocked(rect, this->spacing, id, this->startRects)) {
+            this->startPlaced[id] = 1;
+            grid.insert(id, rect);
+            plants[this->startCrops[id]] += Plot::plantsFor(rect, this->spacings[this->startCrops[id]]);
+            areas[this->startCrops[id]] += (int64_t) rect.w * rect.h;
+        }
+    }
+
+    this->startHarvest = 0.0;
+    for (int crop = 0; crop < cropCount; crop++) {
+        this->startHarvest += this->valueOf(crop, plants[crop], areas[crop]);
+    }
+
+    this->planFarm = farm;
+    this->planRegistryVersion = registry->version;
+}
+
+void LayoutOptimizer::start(Farm* farm, CropRegistry* registry) {
+    if (this->running()) {
+        return;
+    }
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+
+    this->snapshot(farm, registry);
+    this->annealing.cancelled = false;
+    this->finished = false;
+    this->worker = std::thread([this]() {
+        this->layout = this->optimize();
+        this->finished = true;
+    });
+}
+
+bool LayoutOptimizer::running() {
+    return this->worker.joinable() && !this->finished;
+}
+
+void LayoutOptimizer::anneal(Annealing::Chain& chain, Layout* layout) {
+    int plots = this->plots;
+    int cropCount = this->yields.size();
+    SDL_Rect field = this->field;
+    int spacing = this->spacing;
+
+    std::vector<SDL_Rect> rects = this->startRects;
+    std::vector<int> crops = this->startCrops;
+    std::vector<uint8_t> placed = this->startPlaced;
+
+    Grid grid;
+    grid.reset(field, this->cell);
+    for (int id = 0; id < (int) rects.size(); id++) {
+        if (id >= plots || placed[id]) {
+            grid.insert(id, rects[id]);
+        }
+    }
+
+    std::vector<int64_t> plants(cropCount, 0);
+    std::vector<int64_t> areas(cropCount, 0);
+    for (int id = 0; id < plots; id++) {
+        if (placed[id]) {
+            plants[crops[id]] += Plot::plantsFor(rects[id], this->spacings[crops[id]]);
+            areas[crops[id]] += (int64_t) rects[id].w * rects[id].h;
+        }
+    }
+    double harvest = this->startHarvest;
+
+    // a rect can go there if it is big enough, inside the field and clear of everything but the plot itself
+    auto fits = [&](SDL_Rect rect, int id) {
+        return rect.w >= PLOT_MIN_WIDTH && rect.h >= PLOT_MIN_HEIGHT && rect.x >= field.x && rect.y >= field.y &&
+            rect.x + rect.w <= field.x + field.w && rect.y + rect.h <= field.y + field.h &&
+            !grid.blocked(rect, spacing, id, rects);
+    };
+
+    std::mt19937& random = chain.random;
+    int widest = std::max(1, std::max(field.w, field.h) / 4);
+    int kinds = this->changeCrops && !this->candidates.empty() ? 4 : 3;
+
+    for (int batch; (batch = this->annealing.batch(chain)) > 0;) {
+        // steps shrink along with the temperature, from big jumps to single pixels
+        int step = std::max(1, (int) (widest * this->annealing.heat(chain)));
+
+        for (int move = 0; move < batch; move++) {
+            int id = random() % plots;
+            SDL_Rect from = rects[id];
+            SDL_Rect to = from;
+            int crop = crops[id];
+            int toCrop = crop;
+
+            if (!placed[id]) {
+                // somewhere random in the field, at the smallest size half the time
+                bool smallest = random() % 2;
+                to.w = std::min(smallest ? PLOT_MIN_WIDTH : from.w, field.w);
+                to.h = std::min(smallest ? PLOT_MIN_HEIGHT : from.h, field.h);
+                to.x = field.x + random() % (field.w - to.w + 1);
+                to.y = field.y + random() % (field.h - to.h + 1);
+            } else {
+                int kind = random() % kinds;
+                if (kind == 0) {
+                    to.x += (int) (random() % (2 * step + 1)) - step;
+                    to.y += (int) (random() % (2 * step + 1)) - step;
+                } else if (kind == 1) {
+                    to = stretch(from, random() % 4, (int) (random() % (2 * step + 1)) - step);
+                } else if (kind == 2) {
+                    // pushes an edge out as far as it goes, growing can only ever run into more things
+                    int edge = random() % 4;
+                    int room = edge == 0 ? from.x - field.x : edge == 1 ? field.x + field.w - from.x - from.w :
+                        edge == 2 ? from.y - field.y : field.y + field.h - from.y - from.h;
+                    int low = 0;
+                    while (low < room) {
+                        int middle = (low + room + 1) / 2;
+                        if (fits(stretch(from, edge, middle), id)) {
+                            low = middle;
+                        } else {
+                            room = middle - 1;
+                        }
+                    }
+                    to = stretch(from, edge, low);
+                } else {
+                    toCrop = this->candidates[random() % this->candidates.size()];
+                }
+            }
+
+            bool moved = !placed[id] || !SDL_RectEquals(&from, &to);
+            if ((!moved && toCrop == crop) || (moved && !fits(to, id))) {
+                continue;
+            }
+
+            // a new crop packs the plot at its own spacing
+            int64_t fromPlants = placed[id] ? Plot::plantsFor(from, this->spacings[crop]) : 0;
+            int64_t fromArea = placed[id] ? (int64_t) from.w * from.h : 0;
+            int64_t toPlants = Plot::plantsFor(to, this->spacings[toCrop]);
+            int64_t toArea = (int64_t) to.w * to.h;
+
+            double delta;
+            if (toCrop == crop) {
+                delta = this->valueOf(crop, plants[crop] - fromPlants + toPlants, areas[crop] - fromArea + toArea) -
+                    this->valueOf(crop, plants[crop], areas[crop]);
+            } else {
+                delta = this->valueOf(crop, plants[crop] - fromPlants, areas[crop] - fromArea) - this->valueOf(crop, plants[crop], areas[crop]) +
+                    this->valueOf(toCrop, plants[toCrop] + toPlants, areas[toCrop] + toArea) - this->valueOf(toCrop, plants[toCrop], areas[toCrop]);
+            }
+
+            if (!this->annealing.accept(chain, delta)) {
+                continue;
+            }
+
+            if (placed[id]) {
+                grid.remove(id, from);
+            }
+            grid.insert(id, to);
+            plants[crop] -= fromPlants;
+            areas[crop] -= fromArea;
+            plants[toCrop] += toPlants;
+            areas[toCrop] += toArea;
+            rects[id] = to;
+            crops[id] = toCrop;
+            placed[id] = 1;
+            harvest += delta;
+        }
+
+        this->annealing.report(chain, batch, harvest);
+    }
+
+    // added up again from the totals, the running sum drifts a little over millions of moves
+    layout->harvest = 0.0;
+    for (int crop = 0; crop < cropCount; crop++) {
+        layout->harvest += this->valueOf(crop, plants[crop], areas[crop]);
+    }
+
+    rects.resize(plots);
+    layout->rects = std::move(rects);
+    layout->crops = std::move(crops);
+    layout->placed = std::move(placed);
+    layout->placedCount = std::count(layout->placed.begin(), layout->placed.end(), 1);
+}
+
+LayoutOptimizer::Layout LayoutOptimizer::optimize() {
+    auto start = std::chrono::steady_clock::now();
+    int chains = Parallel::workerCount();
+
+    // a move changes about one average plot's harvest, plots are counted at no less than the
+    // smallest size since ones that dont fit yet are placed at it, so the temperatures suit any farm
+    double plantSum = 0.0;
+    for (int id = 0; id < this->plots; id++) {
+        int spacing = this->spacings[this->startCrops[id]];
+        plantSum += std::max(Plot::plantsFor(this->startRects[id], spacing), Plot::plantsFor({0, 0, PLOT_MIN_WIDTH, PLOT_MIN_HEIGHT}, spacing));
+    }
+    double yieldSum = 0.0;
+    for (int crop : this->candidates) {
+        yieldSum += this->yields[crop];
+    }
+    double scale = std::max(1e-6, plantSum / std::max(1, this->plots) * yieldSum / std::max<int>(1, this->candidates.size()));
+    this->annealing.begin(chains, (int64_t) this->sweeps * this->plots, LAYOUT_MOVE_BATCH, scale, LAYOUT_HOT, LAYOUT_COLD);
+
+    std::vector<Layout> layouts(chains);
+    int best = this->annealing.run(this->seed, [&](Annealing::Chain& chain) {
+        Layout& layout = layouts[chain.index];
+        if (this->plots > 0 && this->field.w >= PLOT_MIN_WIDTH && this->field.h >= PLOT_MIN_HEIGHT) {
+            this->anneal(chain, &layout);
+        } else {
+            layout = {this->startRects, this->startCrops, this->startPlaced, this->startHarvest, 0, 0, 0.0f};
+            layout.rects.resize(this->plots);
+        }
+        return layout.harvest;
+    });
+
+    Layout layout = std::move(layouts[best]);
+    layout.placedCount = std::count(layout.placed.begin(), layout.placed.end(), 1);
+    layout.chains = chains;
+    layout.seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    return layout;
+}
+
+int LayoutOptimizer::conflicts(Layout& layout) {
+    std::vector<SDL_Rect> rects = layout.rects;
+    rects.insert(rects.end(), this->obstacles.begin(), this->obstacles.end());
+
+    Grid grid;
+    grid.reset(this->field, this->cell);
+    for (int id = (int) layout.rects.size(); id < (int) rects.size(); id++) {
+        grid.insert(id, rects[id]);
+    }
+
+    // each placed plot is checked against everything placed before it
+    int broken = 0;
+    SDL_Rect field = this->field;
+    for (int id = 0; id < (int) layout.rects.size(); id++) {
+        if (!layout.placed[id]) {
+            continue;
+        }
+
+        SDL_Rect rect = rects[id];
+        bool inside = rect.x >= field.x && rect.y >= field.y && rect.x + rect.w <= field.x + field.w && rect.y + rect.h <= field.y + field.h;
+        broken += !inside || rect.w < PLOT_MIN_WIDTH || rect.h < PLOT_MIN_HEIGHT || grid.blocked(rect, this->spacing, id, rects);
+        grid.insert(id, rect);
+    }
+
+    return broken;
+}
+
+void LayoutOptimizer::apply(Farm* farm, CropRegistry* registry) {
+    // a reload can renumber the crops, and plots made since the run werent laid out
+    if (farm != this->planFarm || registry->version != this->planRegistryVersion || (int) farm->plots.size() != this->plots) {
+        return;
+    }
+
+    // plots that didnt fit go in rows under the field, as wide as it is
+    int parkX = this->field.x;
+    int parkY = this->field.y + this->field.h + this->spacing;
+    int rowHeight = 0;
+
+    farm->history.beginGroup();
+    for (int id = 0; id < this->plots; id++) {
+        Plot* plot = farm->plots[id];
+        SDL_Rect before = plot->bounds;
+        SDL_Rect after = this->layout.rects[id];
+        int crop = this->layout.crops[id];
+
+        if (!this->layout.placed[id]) {
+            if (parkX > this->field.x && parkX + before.w > this->field.x + this->field.w) {
+                parkX = this->field.x;
+                parkY += rowHeight + this->spacing;
+                rowHeight = 0;
+            }
+
+            after = {parkX, parkY, before.w, before.h};
+            crop = plot->crop->index;
+            parkX += before.w + this->spacing;
+            rowHeight = std::max(rowHeight, before.h);
+        }
+
+        bool changed = false;
+        if (!SDL_RectEquals(&before, &after)) {
+            farm->history.recordRect(plot, before, after, false);
+            plot->bounds = after;
+            changed = true;
+        }
+
+        if (crop != plot->crop->index) {
+            CropRegistry::CropEntry* entry = registry->ordered[crop];
+            farm->history.recordCrop(plot, plot->crop, plot->cropIndex, entry, crop);
+            plot->updateProperties(entry, crop);
+            changed = true;
+        }
+
+        if (changed) {
+            farm->markDirty(plot);
+        }
+    }
+    farm->history.endGroup();
+}
+
+void LayoutOptimizer::render(SDL_Renderer* renderer) {
+    SDL_BlendMode mode;
+    SDL_GetRenderDrawBlendMode(renderer, &mode);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+    SDL_SetRenderDrawColor(renderer, 0xC0, 0x30, 0x30, 0x90);
+    SDL_RenderFillRects(renderer, this->obstacles.data(), this->obstacles.size());
+
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xC0);
+    SDL_RenderDrawRect(renderer, &this->field);
+
+    SDL_SetRenderDrawBlendMode(renderer, mode);
+}
+
+void LayoutOptimizer::showField(Farm* farm) {
+    ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+    ImGui::InputInt4("Field", &this->field.x);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Fit To Plots")) {
+        this->fitField(farm);
+    }
+
+    // obstacles are rects like the field, x y width height
+    int removed = -1;
+    for (int i = 0; i < (int) this->obstacles.size(); i++) {
+        ImGui::PushID(i);
+        ImGui::InputInt4("##obstacle", &this->obstacles[i].x);
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Remove")) {
+            removed = i;
+        }
+        ImGui::PopID();
+    }
+    ImGui::PopItemWidth();
+
+    if (removed >= 0) {
+        this->obstacles.erase(this->obstacles.begin() + removed);
+    }
+
+    ImGui::BeginDisabled(this->obstacles.size() >= LAYOUT_MAX_OBSTACLES);
+    if (ImGui::SmallButton("Add Obstacle")) {
+        SDL_Rect& field = this->field;
+        this->obstacles.push_back({field.x + field.w / 4, field.y + field.h / 4, std::max(field.w / 8, 1), std::max(field.h / 8, 1)});
+    }
+    ImGui::EndDisabled();
+}
+
+void LayoutOptimizer::showTargets(CropRegistry* registry) {
+    int count = registry->ordered.size();
+    this->targets.resize(count, 0);
+
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.5);
+    if (ImGui::SliderInt("All Crops", &this->allTargets, 0, 100, this->allTargets ? "%d%%" : "No Target")) {
+        std::fill(this->targets.begin(), this->targets.end(), this->allTargets);
+    }
+
+    float height = std::min(count - 1, 8) * ImGui::GetFrameHeightWithSpacing();
+    ImGui::BeginChild("layout_targets", ImVec2(0, height));
+    {
+        ImGuiListClipper clipper;
+        clipper.Begin(count - 1);
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                int crop = i + 1;
+                ImGui::PushID(crop);
+                ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.5);
+                ImGui::SliderInt(registry->ordered[crop]->name.c_str(), &this->targets[crop], 0, 100, this->targets[crop] ? "%d%%" : "No Target");
+                ImGui::PopID();
+            }
+        }
+    }
+    ImGui::EndChild();
+}
+
+void LayoutOptimizer::show(Farm* farm, CropRegistry* registry) {
+    ImGui::SetNextWindowSize(ImVec2(480, 540), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Layout Optimizer", &this->open)) {
+        ImGui::End();
+        return;
+    }
+
+    // the finished worker is picked up here, a cancelled run has nothing worth showing
+    if (this->finished && this->worker.joinable()) {
+        this->worker.join();
+        this->hasResult = !this->annealing.cancelled;
+    }
+
+    bool busy = this->running();
+
+    ImGui::BeginDisabled(busy);
+    this->showField(farm);
+
+    ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.5);
+    ImGui::SliderInt("Spacing", &this->spacing, 0, 50, "%d px");
+    ImGui::SliderInt("Sweeps", &this->sweeps, 10, 10000, "%d", ImGuiSliderFlags_Logarithmic);
+    ImGui::InputInt("Seed", &this->seed);
+    ImGui::PopItemWidth();
+    ImGui::Checkbox("Change Crops", &this->changeCrops);
+
+    if (ImGui::TreeNode("Target Areas")) {
+        this->showTargets(registry);
+        ImGui::TreePop();
+    }
+
+    if (ImGui::Button("Optimize")) {
+        this->start(farm, registry);
+    }
+    ImGui::EndDisabled();
+
+    if (busy) {
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            this->annealing.cancelled = true;
+        }
+        ImGui::SameLine();
+        ImGui::ProgressBar(this->annealing.progress());
+    }
+
+    // best harvest of any chain at each point of the run so far
+    if (busy || this->hasResult) {
+        float curve[ANNEAL_CURVE];
+        int length = this->annealing.bestCurve(curve);
+
+        if (length > 0) {
+            ImGui::Text("Best Harvest: %.1f lbs", curve[length - 1]);
+            ImGui::PlotLines("##layout_curve", curve, length, 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 60));
+        }
+    }
+
+    if (this->hasResult && !busy) {
+        Layout& layout = this->layout;
+        ImGui::SeparatorText("Layout");
+        ImGui::Text("Harvest: %.1f lbs, was %.1f lbs", layout.harvest, this->startHarvest);
+        ImGui::Text("Placed: %d of %d plots", layout.placedCount, this->plots);
+        ImGui::TextDisabled("%d chains in %.2f s", layout.chains, layout.seconds);
+
+        // the layout's ids and crop indexes are only good for the farm and crop table it was made with
+        bool stale = farm != this->planFarm || registry->version != this->planRegistryVersion || (int) farm->plots.size() != this->plots;
+        ImGui::BeginDisabled(stale);
+        if (ImGui::Button("Apply To Farm")) {
+            this->apply(farm, registry);
+        }
+        ImGui::EndDisabled();
+
+        if (stale) {
+            ImGui::TextDisabled("The farm or crops changed, optimize again to apply");
+        }
+    }
+
+    ImGui::End();
+}
@@ -7,21 +7,58 @@
 
 // entry point
 int main(int argc, char** argv) {
+    // command line tools, these never start sdl, dont need the catalog and load their own crop table
+    if (argc > 1 && strcmp(argv[1], "--headless") == 0) {
+        return Headless::run(argc, argv);
+    }
+
     // create crop data manager and fill it with data
+    // big tables go through the memory mapped loader
     CropRegistry* registry = new CropRegistry();
-    registry->loadFromCSV("crop.csv");
+    std::error_code error;
+    if (std::filesystem::file_size("crop.csv", error) > CSV_FAST_THRESHOLD && !error) {
+        registry->loadFromCSVFast("crop.csv");
+    } else {
+        registry->loadFromCSV("crop.csv");
+    }
 
-    // input stream for farm data
-    std::ifstream stream("farm.json", std::ifstream::binary);
-    App* app;
+    // every csv in the catalog folder is merged, files later in name order take precedence
+    std::vector<std::string> catalogFiles;
+    if (std::filesystem::is_directory("catalog", error)) {
+        for (auto& entry : std::filesystem::directory_iterator("catalog", error)) {
+            if (entry.path().extension() == ".csv") {
+                catalogFiles.push_back(entry.path().string());
+            }
+        }
+    }
 
-    // if file exists, call with stream, otherwise nullptr
-    if (stream.good()) {
-        app = new App(registry, &stream);
-    } else {
-        app = new App(registry, nullptr);
+    if (!catalogFiles.empty()) {
+        std::sort(catalogFiles.begin(), catalogFiles.end());
+        registry->catalog.load(catalogFiles);
+    }
+
+    // timing runs, these never open a window
+    if (argc > 2 && strcmp(argv[1], "--bench") == 0) {
+        return Benchmark::run(argv[2], registry);
     }
-    
+
+    // farms to open can be given on the command line, the first one is shown
+    std::vector<std::string> farms;
+    for (int i = 1; i < argc; i++) {
+        farms.push_back(argv[i]);
+    }
+
+    if (farms.empty()) {
+        farms.push_back("farm.json");
+    }
+
+    // the app loads the farms itself, from their index when there is one
+    App* app = new App(registry, "crop.csv", farms);
+
     // start app
-    return app->run();
+    int status = app->run();
+
+    // destroying the app writes out anything the autosave hasnt gotten to yet
+    delete app;
+    return status;
 }
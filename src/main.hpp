@@ -15,7 +15,7 @@
 
 // include fastcsv, for csv reading
 // https://github.com/ben-strasser/fast-cpp-csv-parser/tree/master
-#define CSV_IO_NO_THREAD
+// threading is left on so file reads overlap with parsing
 #include "FastCSV/csv.h"
 
 // include jsoncpp for json serialization and deserialization
@@ -25,6 +25,13 @@
 // include the c++ std library
 #include <bits/stdc++.h>
 
+// file change notifications for crop hot reloading
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 // window width and height definitions
 #define WINDOW_WIDTH 1200
 #define WINDOW_HEIGHT 680
@@ -34,11 +41,166 @@
 #define PLOT_PADDING (PLOT_LINE_SPACING / 2)
 #define PLOT_MIN_WIDTH 64
 #define PLOT_MIN_HEIGHT 64
+// most plants one plot's lattice holds, rows past it stay empty so a huge imported plot cant overflow the counts
+#define PLOT_MAX_PLANTS (1 << 24)
 #define SIDE_PANEL_WIDTH (0.2)
+// rows an expanded plot takes up in the farm contents list, its name and three lines of details
+#define PLOT_TREE_ROWS 4
+
+// smallest amount of work worth handing to another thread
+#define PARALLEL_BLOCK 512
+
+// lazy loading definitions
+#define FARM_INDEX_MAGIC 0x58444946
+#define FARM_INDEX_VERSION 1
+#define PLOT_DETAILS_PENDING 0
+#define PLOT_DETAILS_LOADING 1
+#define PLOT_DETAILS_READY 2
+
+// autosave definitions
+#define AUTOSAVE_DEBOUNCE_MS 2000
+#define FRAME_HISTORY 240
+
+// undo history definitions
+#define EDIT_RECT 0
+#define EDIT_CROP 1
+#define EDIT_NAME 2
+#define EDIT_DEVIATION 3
+#define HISTORY_MEMORY_LIMIT (8 << 20)
+
+// crop growth definitions, used when the crop table has no days or start column
+// days are counted from the start of the season
+#define CROP_DEFAULT_GROWTH_DAYS 90
+#define CROP_DEFAULT_PLANTING_DAY 0
+
+// crop spacing definitions, plants sit on a square lattice this many pixels apart
+// the default is used when the crop table has no spacing column, the minimum keeps a typo from making millions of plants
+#define CROP_DEFAULT_SPACING PLOT_LINE_SPACING
+#define CROP_MIN_SPACING 2
+
+// crop hot reload definitions
+#define CROP_WATCH_POLL_MS 250
+#define CROP_WATCH_SETTLE_MS 100
+
+// crop tables bigger than this are loaded with the memory mapped tokenizer
+#define CSV_FAST_THRESHOLD (1 << 20)
+// bytes of a chunk scanned for delimiters at a time
+#define CSV_SCAN_WINDOW (1 << 16)
+
+// workspace definitions
+#define WORKSPACE_MEMORY_BUDGET_MB 256
+
+// changes a farm remembers the plot of, views further behind than this check every plot
+#define FARM_CHANGE_LOG 1024
+
+// minimap definitions, the texture is at most this many texels along its longer side
+#define MINIMAP_SIZE 256
+#define MINIMAP_BACKGROUND 40
+#define MINIMAP_DISPLAY_HEIGHT 160
+
+// plot search definitions, renamed plots are checked by hand until there are more than the limit
+#define PLOT_SEARCH_STALE_LIMIT 4096
+#define PLOT_SEARCH_ROWS 6
+
+// farm stats definitions, harvests are kept in thousandths of a lb and deviations in hundredths
+#define STATS_HARVEST_SCALE 1000
+#define STATS_DEVIATION_SCALE 100
+// a plot's deviation is capped at this many hundredths of a lb, so its square stays exact and a billion of them still add up
+#define STATS_MAX_DEVIATION 1e14
+
+// harvest simulation definitions, work is handed out in blocks of plots by blocks of trials
+#define SIMULATION_PLOT_BLOCK 4096
+#define SIMULATION_TRIAL_BLOCK 64
+#define SIMULATION_MAX_TRIALS 20000
+#define SIMULATION_BINS 40
+
+// growth simulation definitions, days are kept in bytes so a season has to stay under 255 days
+// plots go in over a stagger of a couple weeks and are replanted at most a few times a season
+#define GROWTH_SEASON_DAYS 240
+#define GROWTH_MAX_PLANTINGS 4
+#define GROWTH_STAGGER_DAYS 14
+#define GROWTH_PLOT_BLOCK 4096
+#define GROWTH_STAGE_FALLOW 0
+#define GROWTH_STAGE_SEEDLING 1
+#define GROWTH_STAGE_GROWING 2
+#define GROWTH_STAGE_RIPENING 3
+#define GROWTH_STAGE_HARVESTED 4
+#define GROWTH_STAGES 5
+
+// annealing definitions, every chain's score is kept at this many evenly spaced points of its run
+#define ANNEAL_CURVE 100
+
+// crop rotation definitions, plots closer than the neighbor distance in pixels share pests
+// every annealing chain keeps a whole plan, so big farms run fewer chains to stay in the memory budget
+#define ROTATION_MAX_SEASONS 8
+#define ROTATION_NEIGHBOR_DISTANCE 10
+#define ROTATION_MOVE_BATCH (1 << 16)
+#define ROTATION_MEMORY_BUDGET (64 << 20)
+
+// layout optimizer definitions, chains report in after every batch of moves
+// the grid a chain checks placements with has at most LAYOUT_MAX_CELLS cells
+#define LAYOUT_MOVE_BATCH (1 << 14)
+#define LAYOUT_MAX_CELLS (1 << 16)
+#define LAYOUT_MAX_OBSTACLES 32
+
+// heatmap definitions, yield and risk are measured per plant spot, a PLOT_LINE_SPACING square
+#define HEATMAP_YIELD_PER_AREA 0
+#define HEATMAP_DEVIATION 1
+#define HEATMAP_RISK 2
+#define HEATMAP_METRICS 3
+#define HEATMAP_AREA_UNIT (PLOT_LINE_SPACING * PLOT_LINE_SPACING)
+
+// plant store definitions, a plant is one byte, its growth stage in the low bits and the top bit set if it came up
+#define PLANT_ALIVE 0x80
+#define PLANT_STAGE_MASK 0x07
+#define PLANT_DEFAULT_EMERGENCE 90
+
+// scenario batch definitions, the scenario file is read and evaluated this many lines at a time
+#define SCENARIO_CHUNK 8192
+#define SCENARIO_BLOCK 64
+
+// headless definitions, validation lists this many problems of each kind before only counting them
+#define HEADLESS_MAX_LISTED 20
+
+// allocation counting is only built in with -DALLOC_TRACKING, which only the bench build passes
+// release builds keep the standard operator new and never hook the sdl or imgui allocators
 
 class App;
 struct Plot;
+struct PlotRecord;
+class SearchIndex;
+struct SearchQuery;
+class CropCatalog;
 class CropRegistry;
+struct CropChange;
+struct CropReload;
+class Autosave;
+class FarmFile;
+class Parallel;
+class PlotGrid;
+class DetailLoader;
+class Farm;
+class Workspace;
+class History;
+class Benchmark;
+class CropWatcher;
+class MappedFile;
+class CsvScanner;
+class AllocTracker;
+class PlotTable;
+class Minimap;
+class PlotSearch;
+class PlotWindows;
+class FarmStats;
+class HarvestSimulation;
+class GrowthSimulation;
+class RotationPlanner;
+class Annealing;
+class LayoutOptimizer;
+class ScenarioBatch;
+class Heatmap;
+class PlantStore;
+class Headless;
 
 class App {
 private:
@@ -48,13 +210,79 @@ private:
 
     // app variables
     bool closed;
-    std::vector<Plot*> plots;
     Plot* selectedPlot;
     CropRegistry* registry;
     SDL_Point mouse;
     SDL_Point deltaMouse;
-    std::string farmName;
-    int plotCount;
+    Uint64 startTime;
+    float startupMs;
+
+    // reloads the crop table whenever its file changes
+    std::string cropFile;
+    CropWatcher* cropWatcher;
+
+    // every open farm, and the one being edited
+    Workspace* workspace;
+    Farm* farm;
+    char openPathBuffer[256];
+    int autosaveDelay;
+    int memoryBudget;
+
+    // search box of the crop picker, only one can be open at a time
+    char cropSearchBuffer[128];
+    SearchQuery* cropSearch;
+
+    // region and season the crop catalog is looked up with, -1 means any
+    int catalogRegion;
+    int catalogSeason;
+
+    // frame timing, used to make sure background work never shows up as a hitch
+    float frameTimes[FRAME_HISTORY];
+    int frameIndex;
+
+    // heap allocations made by each frame, a frame where nothing happens should make none
+    float frameAllocations[FRAME_HISTORY];
+    bool allocationWindowOpen;
+
+    // name field of the side panel, only copied back into the farm when it is edited
+    char farmNameBuffer[128];
+
+    // side by side list of every plot
+    PlotTable* plotTable;
+
+    // whole farm overview in the side panel
+    Minimap* minimap;
+
+    // plots with their config window open
+    PlotWindows* plotWindows;
+
+    // harvest totals for the whole farm and every crop
+    FarmStats* farmStats;
+
+    // spread of the farm's harvest, sampled from every plot's deviance
+    HarvestSimulation* simulation;
+
+    // day by day growth of every plot over a season, scrubbed through on a timeline
+    GrowthSimulation* growth;
+
+    // crops for every plot over the next few seasons
+    RotationPlanner* rotation;
+
+    // places and sizes every plot inside a field to get the most harvest out of it
+    LayoutOptimizer* layout;
+
+    // finding plots by name or crop, matches are outlined on the canvas
+    PlotSearch* plotSearch;
+
+    // plots shaded by yield or risk instead of crop color
+    Heatmap* heatmap;
+
+    // every plant of every plot, and which of them came up
+    PlantStore* plantStore;
+
+    // one hatching pattern every plot is drawn with, tinted to the plot's color
+    SDL_Texture* hatchTexture;
+    int hatchSize;
 
     // assets
     SDL_Cursor* handCursor;
@@ -64,7 +292,9 @@ private:
 
 public:
     // constructor, takes care of initializing SDL2 and IMGUI
-    App(CropRegistry* registry, std::ifstream* src);
+    // every file is added to the workspace and the first one is opened
+    // the registry's source file is watched for changes
+    App(CropRegistry* registry, std::string cropFile, std::vector<std::string> filenames);
     // destructor, destroys window and closes SDL2 and IMGUI contexts
     ~App();
 
@@ -79,14 +309,124 @@ private:
     void updateCursor();
     // rendering the scene
     void renderEngine();
-    // adds a new plot
-    void addNewPlot(Plot* plot);
-    // saves farm data to .json file
-    void saveFarm(std::string filename);
+    // makes a different farm the one being edited
+    void switchFarm(std::string filename);
+    // draws the list of farms in the workspace
+    void showWorkspace();
+    // draws the plot list, only the rows in view are built
+    void showContents();
+    // draws the frame time and autosave statistics
+    void showPerformance();
+    // draws the searchable crop list, selection is an index into the registry's ordered crops
+    void showCropPicker(int* selection);
+    // draws the region and season pickers for the crop catalog
+    void showCatalog();
+    // draws the per frame allocation counts
+    void showAllocations();
 
 private:
     // load cursor icons
     void loadAssets();
+    // redraws the hatching texture so it covers plots up to size pixels across
+    void buildHatch(int size);
+};
+
+// case insensitive search over a list of names, ids are positions in the list
+// queries shorter than three characters match the start of names, longer ones match anywhere
+// and are answered by intersecting the lists of names each of their trigrams shows up in
+class SearchIndex {
+private:
+    // lowercased names back to back, name i is text[offsets[i], offsets[i + 1])
+    std::string text;
+    std::vector<uint32_t> offsets;
+    // ids sorted by name
+    std::vector<int> order;
+    // sorted ids of the names each trigram shows up in
+    std::unordered_map<uint32_t, std::vector<int>> trigrams;
+    // bumped by every build, so queries know their results are stale
+    int generation;
+
+public:
+    SearchIndex();
+
+public:
+    // indexes a new list of names, replacing the old one
+    void build(const std::vector<std::string>& names);
+    // takes over an index built somewhere else, like on a worker thread, other is left empty
+    void adopt(SearchIndex& other);
+    // number of names indexed
+    int size();
+    // ids of every name matching query, in ascending order
+    void find(std::string query, std::vector<int>* out);
+    // changes the text of a query, when the new text only narrows the old one just the old results are checked
+    void update(SearchQuery* query, const char* text);
+    // lowercased name of an id
+    std::string_view name(int id);
+    // checks a lowercased name against an already lowercased query, the same way find does
+    static bool matches(std::string_view name, const std::string& query);
+
+private:
+    bool matches(int id, const std::string& query);
+    uint64_t nameKey(int id, size_t depth);
+    void sortNames(std::vector<std::pair<uint64_t, int>>& keys, size_t first, size_t last, size_t depth);
+};
+
+// a query being typed, keeps its results so the next keystroke can narrow them down
+struct SearchQuery {
+    std::string text;
+    std::vector<int> results;
+    // which build of the index the results came from
+    int generation;
+
+    SearchQuery();
+};
+
+// per region, season and cultivar yields merged from any number of csv files
+// stored by column, the string columns are dictionary encoded so a row is four ints and a double
+class CropCatalog {
+public:
+    // one dictionary encoded string column, code 0 is always the empty string
+    struct Dictionary {
+        std::vector<std::string> values;
+        std::unordered_map<std::string, int> codes;
+
+        Dictionary();
+        // code for a value, adding it if it hasnt been seen yet
+        int encode(std::string_view value);
+        // code for a value, -1 if it was never seen
+        int find(const std::string& value);
+    };
+
+    // dictionaries for the string columns
+    Dictionary crops;
+    Dictionary regions;
+    Dictionary seasons;
+    Dictionary cultivars;
+
+    // the columns, rows are kept sorted by crop, region, season and then cultivar
+    std::vector<int> crop;
+    std::vector<int> region;
+    std::vector<int> season;
+    std::vector<int> cultivar;
+    std::vector<double> yield;
+    // which file each row came from, as an index into sources
+    std::vector<int> source;
+    std::vector<std::string> sources;
+
+public:
+    // reads every file across all cores and merges them, replacing whatever was loaded before
+    // when two rows have the same crop, region, season and cultivar the one from the later file wins
+    bool load(std::vector<std::string> filenames);
+    // number of rows after merging
+    int rows();
+    // rows of a crop, a region or season code of -1 matches anything
+    void filter(int crop, int region, int season, std::vector<int>* out);
+    // average yield over the rows filter would return, sets count to how many there were
+    double averageYield(int crop, int region, int season, int* count);
+
+private:
+    // first row and one past the last row starting with the given codes, only the first depth codes are compared
+    std::pair<int, int> range(int crop, int region, int season, int depth);
 };
 
 // manager for holding all the information for a specific crop
@@ -101,12 +441,30 @@ public:
         double avgYield;
         // color to be displayed for each plot
         SDL_Color color;
+        // days from planting to harvest, and the earliest day of the season it can be planted
+        int growthDays;
+        int plantingDay;
+        // distance between plants in pixels, both along and across rows
+        int spacing;
+        // plant family, crops of one family share pests and shouldnt follow each other, the crop's own name if not given
+        std::string family;
+        // bumped every time a reload changes this crop, plots compare it against their copy
+        int version;
+        // position in the ordered list, this is what plots store as their crop index
+        int index;
 
         CropEntry(std::string name, double avgYield, int red, int green, int blue);
     };
 
     // actual data being stored, using crop name as key in hash table
     std::unordered_map<std::string, CropEntry*> registry;
+    // every crop sorted by name with NO SELECTION first, and a search index over their names
+    std::vector<CropEntry*> ordered;
+    SearchIndex search;
+    // bumped whenever a reload changes the table
+    int version;
+    // finer grained yields by region, season and cultivar, empty unless catalog files were loaded
+    CropCatalog catalog;
 
 public:
     CropRegistry();
@@ -117,8 +475,18 @@ private:
 public:
     // add a new entry
     void addEntry(std::string name, double yield, int red, int green, int blue);
+    // make room for this many more crops up front
+    void reserve(size_t count);
+    // add many entries at once, entries with a name already in the table are deleted
+    void addEntries(std::vector<CropEntry*>& entries);
     // load crop data from a csv table
     void loadFromCSV(std::string filename);
+    // same table format, but memory mapped and split across every core with a simd delimiter scan
+    // meant for very large tables, returns false if the file cant be read
+    bool loadFromCSVFast(std::string filename);
+    // the parsing half of loadFromCSVFast, every chunk's entries in file order, safe to call from any thread
+    // the entries belong to the caller, size is set to the size of the file
+    static bool parseCSVFast(std::string filename, std::vector<std::vector<CropEntry*>>* chunks, size_t* size);
     // get a crop's data from its name
     CropEntry* access(std::string name);
     // get list of crops stored
@@ -127,6 +495,271 @@ public:
     char** getKeyListAsCSTRS();
     // free allocated memory for char* array from previous function
     void freeCSTRS(char** list, int size);
+    // apply a reload, changed crops are updated in place so plots keep pointing at them
+    // every plot of the farm picks up the new values right away, other farms do when they are next drawn
+    void applyChanges(CropReload& reload, Farm* farm);
+    // rebuilds the ordered list and search index, called once the table is loaded or gains crops
+    void buildIndex();
+};
+
+// new values for one crop after its file was reloaded
+struct CropChange {
+    std::string name;
+    double avgYield;
+    SDL_Color color;
+    int growthDays;
+    int plantingDay;
+    std::string family;
+    int spacing;
+};
+
+// everything a reload hands over to the main thread
+// when crops were added the new order and its search index come along, so the main thread never sorts
+struct CropReload {
+    std::vector<CropChange> changes;
+    bool reordered;
+    // every crop name sorted with NO SELECTION first, the same order buildIndex makes
+    std::vector<std::string> order;
+    SearchIndex search;
+
+    CropReload();
+};
+
+// watches the crop file and reparses it on a background thread when it changes
+// the worker compares against its own copy of the table, so the live registry is only
+// ever touched by the main thread when it picks up the changes
+class CropWatcher {
+private:
+    std::string filename;
+    std::thread worker;
+    std::atomic<bool> stopping;
+
+    // kept open for the watcher's whole life so saves made while settling or reloading arent missed
+    // inotify on linux, everywhere else the modification time as of the last read
+    int notify;
+    std::filesystem::file_time_type lastWrite;
+
+    // changes waiting for the main thread, newer reloads replace older values of the same crop
+    // and a newer order replaces an older one
+    std::mutex lock;
+    std::unordered_map<std::string, CropChange> pending;
+    bool pendingReorder;
+    std::vector<std::string> pendingOrder;
+    SearchIndex pendingSearch;
+
+    // the worker's copy of the table as of the last reload
+    std::unordered_map<std::string, CropChange> known;
+
+public:
+    // copies the registry as it is now, call from the main thread
+    CropWatcher(std::string filename, CropRegistry* registry);
+    ~CropWatcher();
+
+public:
+    // takes any waiting changes, never blocks
+    bool poll(CropReload* reload);
+
+private:
+    // worker thread loop
+    void run();
+    // starts watching the file, false if it cant be watched
+    bool watch();
+    // sleeps until the file changes or the watcher stops, returns false when stopping
+    bool waitForChange();
+    // forgets the changes seen so far, call right before reading since the read covers them
+    void consumeChanges();
+    // parses the file and queues whatever differs from the last version
+    // big tables are parsed with the same memory mapped loader startup uses
+    void reload();
+    // reads every row of the file, the first row of a name wins, false if it couldnt be read
+    bool readTable(std::unordered_map<std::string, CropChange>* latest);
+};
+
+// one change to one plot, only the fields that changed are kept
+struct Edit {
+    uint8_t type;
+    // set while the edit can still absorb more of the same change, like the rest of a drag
+    bool open;
+    int plotId;
+    // edits sharing a group are undone and redone together
+    int group;
+
+    union {
+        struct { SDL_Rect from, to; } rect;
+        struct { CropRegistry::CropEntry* from; CropRegistry::CropEntry* to; int fromIndex, toIndex; } crop;
+        struct { float from, to; } value;
+    };
+
+    // only renames carry strings, old name then new name
+    std::string* names;
+};
+
+// undo and redo for plot edits
+// edits are stored as deltas, so undoing or redoing costs the size of the edit and not the farm
+class History {
+private:
+    std::deque<Edit> edits;
+    // edits before the cursor are applied, edits from it on can be redone
+    int cursor;
+    int nextGroup;
+    int currentGroup;
+    size_t bytes;
+    size_t limit;
+
+public:
+    History();
+    ~History();
+
+public:
+    // record a move or resize, drags keep extending the same edit until sealed
+    void recordRect(Plot* plot, SDL_Rect from, SDL_Rect to, bool coalesce);
+    // record a crop change
+    void recordCrop(Plot* plot, CropRegistry::CropEntry* from, int fromIndex, CropRegistry::CropEntry* to, int toIndex);
+    // record a rename, typing into the same plot keeps extending the same edit until sealed
+    void recordName(Plot* plot, const char* from, const char* to);
+    // record a deviation change, dragging the slider keeps extending the same edit until sealed
+    void recordDeviation(Plot* plot, float from, float to);
+    // stops the last edit from absorbing any more changes
+    void seal();
+    // everything recorded between these is undone as one step
+    void beginGroup();
+    void endGroup();
+
+    // step back or forward one group, returns false when there is nothing to do
+    bool undo(Farm* farm);
+    bool redo(Farm* farm);
+    bool canUndo();
+    bool canRedo();
+    // number of edits and bytes held
+    int size();
+    size_t memoryUse();
+    // change the memory cap, oldest edits are dropped to stay under it
+    void setLimit(size_t bytes);
+
+private:
+    // drops anything redoable and adds the edit
+    void push(Edit& edit);
+    // the last applied edit if it can still be extended with this kind of change to this plot
+    Edit* openEdit(int type, int plotId);
+    // puts one side of an edit onto its plot
+    void apply(Edit& edit, bool forward, Farm* farm);
+    // bytes an edit takes up, including its strings
+    static size_t editSize(Edit& edit);
+    static void release(Edit& edit);
+};
+
+// one farm file and everything that goes with it
+class Farm {
+public:
+    std::string filename;
+    std::string name;
+    std::vector<Plot*> plots;
+
+    // background loading of plot names and deviations when the farm came from its index
+    DetailLoader* detailLoader;
+
+    // autosave and change tracking
+    Autosave* autosave;
+    std::vector<Plot*> dirtyPlots;
+    // bumped by every change, views built from the plots compare it to know when to refresh
+    uint64_t version;
+    // id of the plot changed by each of the last FARM_CHANGE_LOG versions, indexed by version % FARM_CHANGE_LOG
+    int changeLog[FARM_CHANGE_LOG];
+    // reused every frame, so dragging a plot doesnt allocate
+    std::vector<PlotRecord> submitted;
+    bool nameDirty;
+    bool autosaveSeeded;
+
+    // undo and redo for edits made to this farm
+    History history;
+
+    // ids of the plots expanded in the farm contents list, kept sorted
+    std::vector<int> expandedPlots;
+
+    // bytes of the plots themselves and their crop names, counted as plots come in so memoryUse never walks them
+    size_t plotBytes;
+
+public:
+    // loads from the index when it is up to date, then the json, otherwise starts empty
+    Farm(std::string filename, CropRegistry* registry, int autosaveDelay);
+    // writes out anything not yet saved, then frees every plot
+    ~Farm();
+
+public:
+    // per frame housekeeping, starts the autosave once the details are in
+    void update();
+    // adds a new plot
+    void addPlot(Plot* plot);
+    // saves farm data to .json file, returns false if it couldnt be written
+    bool save(std::string filename);
+    // flags a plot as changed so the autosave picks it up
+    void markDirty(Plot* plot);
+    // hands all changes made this frame over to the autosave
+    void submitChanges();
+    // loads a plot's details right away if the background loader hasnt gotten to it
+    void requireDetails(Plot* plot);
+    // rough number of bytes the farm takes up in memory, including its history and the autosave's copy
+    size_t memoryUse();
+    // adds the id of every plot changed after version to ids, a plot changed several times can come up more than once
+    // recent changes come straight from the change log, older ones mean checking every plot's revision
+    void changedSince(uint64_t version, std::vector<int>* ids);
+
+private:
+    // gives the autosave the full farm once every plot is loaded
+    void seedAutosave();
+    // bytes one plot adds to plotBytes
+    static size_t plotSize(Plot* plot);
+};
+
+// every farm opened this session, recently used ones stay loaded
+// farms are kept most recently used first, and the least recently used are let go
+// once the loaded farms go over the memory budget
+class Workspace {
+private:
+    CropRegistry* registry;
+    int autosaveDelay;
+    size_t memoryBudget;
+
+    // loaded farms, most recently used first
+    std::list<Farm*> resident;
+
+    // a farm being written out and freed on its own thread, done is set once it is gone
+    struct Retiring {
+        std::string filename;
+        std::thread thread;
+        std::unique_ptr<std::atomic<bool>> done;
+    };
+    std::vector<Retiring> retiring;
+
+public:
+    // every farm file known to the workspace, in the order they were added
+    std::vector<std::string> files;
+
+public:
+    Workspace(CropRegistry* registry, size_t memoryBudget, int autosaveDelay);
+    // saves and frees every farm
+    ~Workspace();
+
+public:
+    // adds a file to the list without loading it
+    void add(std::string filename);
+    // returns the farm for a file, loading it if needed, and marks it most recently used
+    Farm* open(std::string filename);
+    // true if the farm for this file is in memory
+    bool isResident(const std::string& filename);
+    // change the budget, takes effect on the next open
+    void setMemoryBudget(size_t bytes);
+    // autosave delay used for farms loaded from now on
+    void setAutosaveDelay(int ms);
+    // total memory of all loaded farms
+    size_t memoryUse();
+
+private:
+    // lets go of least recently used farms until under budget, the active farm always stays
+    // farms that finished retiring since the last call are joined here too
+    void evict();
+    // waits for a farm that is being written out, so it can be loaded again safely
+    void waitForRetired(std::string filename);
 };
 
 struct Plot {
@@ -143,12 +776,20 @@ struct Plot {
     SDL_Point mouse;
 
     // plot data
-    bool windowOpen;
-    SDL_Point windowPos;
     char plotName[128];
     int id;
 
+    // set when the plot has changes the autosave hasnt seen yet
+    bool dirty;
+    // the farm's version as of the last change to this plot, see Farm::version
+    uint64_t revision;
+
+    // whether the name and deviation have been loaded, see DetailLoader
+    std::atomic<int> details;
+
     // crop data
+    CropRegistry::CropEntry* crop;
+    int cropVersion;
     std::string cropName;
     int cropIndex;
     float expectedYield;
@@ -174,12 +815,1171 @@ struct Plot {
     void updateFromInputs(int xin, int yin, int win, int hin, std::vector<Plot*>& plots);
     // update crop data when changed
     void updateProperties(CropRegistry::CropEntry* entry, int index);
+    // picks up the crop's new yield and color if it was reloaded, returns true if it was
+    // a reload only syncs the farm being edited, so anything reading every plot of a farm calls this first
+    // for farms that were open in the background at the time
+    bool syncCrop();
     // register when the plot has been right clicked, returns true if it has been and false otherwise
     bool registerClick(const SDL_Point* p);
-    // render the plot
-    void render(SDL_Renderer* renderer);
+    // render the plot, the hatching is copied out of a shared texture of white lines
+    void render(SDL_Renderer* renderer, SDL_Texture* hatch);
     // move the plot in a direction
     void move(int deltaX, int deltaY);
     // check for any bounding box collisions with other plots
     bool checkCollisions(std::vector<Plot*>& list);
+    // copy everything that gets saved into a record
+    void toRecord(PlotRecord* record);
+    // true once the name and deviation are safe to read
+    bool hasDetails();
+    // the plant lattice inside the padding, spaced by the crop
+    int plantColumns();
+    int plantRows();
+    // plants on the lattice, never more than PLOT_MAX_PLANTS
+    int64_t plantCount();
+    // plants a plot of these bounds holds with a crop spaced this far apart, capped the same way
+    static int64_t plantsFor(SDL_Rect bounds, int spacing);
+    // expected harvest of the whole plot in lbs
+    double expectedHarvest();
+};
+
+// plain copy of a plot's saved fields, safe to hand over to other threads
+struct PlotRecord {
+    int id;
+    SDL_Rect bounds;
+    char name[128];
+    std::string crop;
+    int cropIndex;
+    float deviation;
+};
+
+// byte range of one plot object inside a farm file
+struct PlotSpan {
+    int begin;
+    int end;
+};
+
+// reading and writing farm files
+class FarmFile {
+public:
+    // serialize a farm to json, written to a temporary file first so a crash never leaves half a farm
+    // the index is rewritten alongside it
+    static bool write(std::string filename, std::string farmName, std::vector<PlotRecord>& records);
+    // read a whole file into memory
+    static bool readAll(std::string filename, std::string* buffer);
+    // load a farm from json text, the plot array is split up and parsed on every core
+    // spans is optional, and receives where each plot was found in the text
+    static bool load(const std::string& buffer, CropRegistry* registry, std::string* farmName, std::vector<Plot*>* plots, std::vector<PlotSpan>* spans);
+    // find where every element of the top level "plots" array starts and ends without parsing it
+    // arrayBegin and arrayEnd are set to the positions of the brackets
+    static bool scanPlots(const std::string& buffer, std::vector<PlotSpan>* spans, int* arrayBegin, int* arrayEnd);
+    // turn one parsed plot object into a plot
+    static Plot* plotFromJson(Json::Value& data, CropRegistry* registry);
+
+    // the index is a small binary file next to the json holding only what is needed to draw the farm
+    // (bounds and crop) plus where each plot's full record sits in the json
+    static std::string indexName(std::string filename);
+    static bool writeIndex(std::string filename, std::string farmName, std::vector<PlotRecord>& records, std::vector<PlotSpan>& spans);
+    // loads plots from the index with their details still pending
+    // fails if the index is missing or the json changed since it was written
+    static bool loadIndex(std::string filename, CropRegistry* registry, std::string* farmName, std::vector<Plot*>* plots, std::vector<PlotSpan>* spans);
+};
+
+// fills in plot names and deviations from the json after a farm was loaded from its index
+// every plot is claimed through its details field, so the worker and the main thread never load the same plot
+class DetailLoader {
+private:
+    std::string filename;
+    std::vector<Plot*> plots;
+    std::vector<PlotSpan> spans;
+    std::thread worker;
+    std::atomic<bool> cancelled;
+    std::atomic<bool> finished;
+
+public:
+    DetailLoader(std::string filename, std::vector<Plot*>& plots, std::vector<PlotSpan>& spans);
+    // stops the worker early if it is still going
+    ~DetailLoader();
+
+public:
+    // loads one plot on the calling thread unless it is already loaded, waits if the worker is on it
+    void require(Plot* plot);
+    // true once every plot has its details
+    bool done();
+    // blocks until every plot has its details
+    void wait();
+
+private:
+    // worker thread, reads the json and loads every plot still pending
+    void run();
+    // parse one plot object and copy its details over
+    static void loadDetails(Plot* plot, const char* begin, const char* end, Json::CharReader* reader);
+};
+
+// timing runs for the heavier parts of the app, started with --bench <name>
+class Benchmark {
+public:
+    // runs a benchmark by name, returns the exit code for main
+    static int run(std::string name, CropRegistry* registry);
+
+private:
+    // 10k step undo history on a 100k plot farm
+    static void history(CropRegistry* registry);
+    // loading a 500k row crop table with both csv loaders
+    static void csv();
+    // allocations made by the farm side of idle and dragging frames
+    static void frame(CropRegistry* registry);
+    // harvest simulation samples per second on a 1M plot farm
+    static void simulation(CropRegistry* registry);
+    // a full season of daily growth on a 1M plot farm
+    static void growth(CropRegistry* registry);
+    // a four season rotation plan for a 50k plot farm
+    static void rotation(CropRegistry* registry);
+    // laying out 2000 plots in a field with obstacles
+    static void layout(CropRegistry* registry);
+    // heatmap refreshes on a 500k plot farm, from scratch and while dragging a plot
+    static void heatmap(CropRegistry* registry);
+    // sowing and counting the plants of a 500k plot farm, from scratch and while resizing a plot
+    static void plants(CropRegistry* registry);
+};
+
+// command line tools for scripts and servers, started with --headless <command>
+// nothing here starts sdl, so a run over thousands of farms only costs reading them
+class Headless {
+public:
+    // runs the command named after --headless, returns the exit code for main
+    // loads the crop table itself, from --crops or crop.csv in the working directory
+    static int run(int argc, char** argv);
+
+private:
+    // checks every farm for overlapping plots and plots with no area, fails if any farm has either
+    static int validate(std::vector<std::string>& files, CropRegistry* registry);
+    // harvest totals of every farm, overall and by crop
+    static int stats(std::vector<std::string>& files, CropRegistry* registry);
+    // writes a farm out again under another name, as json with its index next to it
+    static int convert(std::string input, std::string output, CropRegistry* registry);
+    // writes the index next to every farm, so the app opens them without parsing the json
+    static int index(std::vector<std::string>& files, CropRegistry* registry);
+
+    // loads the crop table the same way the app does, false with a message if it cant be read
+    static bool loadCrops(std::string filename, CropRegistry* registry);
+    // loads every plot of a farm with its details, spans is optional like in FarmFile::load
+    static bool load(std::string filename, CropRegistry* registry, std::string* farmName, std::vector<Plot*>* plots, std::vector<PlotSpan>* spans);
+    // counts every pair of plots that overlap, the first HEADLESS_MAX_LISTED of them go in listed
+    static int64_t overlaps(std::vector<Plot*>& plots, std::vector<std::pair<int, int>>* listed);
+};
+
+// read only view of a whole file, memory mapped
+class MappedFile {
+public:
+    const char* data;
+    size_t size;
+
+private:
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#else
+    int fd;
+#endif
+
+public:
+    MappedFile(std::string filename);
+    ~MappedFile();
+
+public:
+    // true if the file was opened and mapped
+    bool good();
+};
+
+// window listing every plot of a farm with sortable, filterable columns
+// the columns are copied out of the plots into flat arrays, and the sorted order is kept
+// until the sort, the filter or the farm's data actually changes
+class PlotTable {
+public:
+    bool open;
+
+private:
+    // what the cached columns were built from
+    Farm* farm;
+    uint64_t farmVersion;
+    int registryVersion;
+    int plotCount;
+    bool detailsDone;
+
+    // columns, indexed by plot id
+    std::vector<std::string> names;
+    std::vector<int> crops;
+    std::vector<int> areas;
+    std::vector<int> plants;
+    std::vector<float> harvests;
+    std::vector<float> deviations;
+
+    // every id in sort order, and the ones that pass the filter
+    std::vector<int> sorted;
+    std::vector<int> rows;
+    int sortColumn;
+    bool ascending;
+    bool sortDirty;
+    bool filterDirty;
+
+    // filter inputs, a crop index of 0 shows every crop
+    char nameFilter[128];
+    int cropFilter;
+
+    // plots changed since the last refresh, kept around so a drag doesnt allocate
+    std::vector<int> changed;
+
+public:
+    PlotTable();
+
+public:
+    // draws the window, clicking a row opens that plot's config window
+    void show(Farm* farm, CropRegistry* registry, PlotWindows* windows);
+    // forgets the cached columns, for when a different farm is shown
+    void reset();
+
+private:
+    // copies one plot into the columns, returns a bit for every column that changed
+    int refreshRow(Plot* plot);
+    // brings the columns up to date with the farm, only touching plots changed since the last call
+    void refresh(Farm* farm, CropRegistry* registry);
+    void sort();
+    void filter();
+};
+
+// low resolution texture of the whole farm, every texel keeps the color sums of the plots covering it
+// so an edited plot is taken off and put back on without touching the rest, and only the texels
+// that changed are uploaded
+class Minimap {
+private:
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;
+    int width;
+    int height;
+
+    // world units per texel, and the area of the world the texture covers
+    int scale;
+    SDL_Rect world;
+
+    // r, g, b and covered area of every texel, and the pixels made from them
+    std::vector<int64_t> sums;
+    std::vector<uint32_t> pixels;
+
+    // where each plot was last drawn and with which color, indexed by plot id
+    std::vector<SDL_Rect> drawnRects;
+    std::vector<SDL_Color> drawnColors;
+
+    // what the texture was built from, and the texels that still have to be uploaded
+    Farm* farm;
+    uint64_t farmVersion;
+    int registryVersion;
+    SDL_Rect dirty;
+    // plots changed since the last refresh, kept around so a drag doesnt allocate
+    std::vector<int> changed;
+
+public:
+    Minimap(SDL_Renderer* renderer);
+    ~Minimap();
+
+public:
+    // draws the map, clicking a plot on it opens its config window
+    void show(Farm* farm, CropRegistry* registry, PlotWindows* windows);
+    // rebuilds everything on the next show, for when a different farm is shown
+    void reset();
+    // makes the texture again on the next show, for when the renderer lost its textures
+    void invalidate();
+
+private:
+    // brings the texture up to date with the farm, only touching plots changed since the last call
+    void refresh(Farm* farm, CropRegistry* registry);
+    void rebuild(Farm* farm);
+    bool update(Plot* plot);
+    void splat(SDL_Rect rect, SDL_Color color, int sign);
+    void shade();
+};
+
+// expected harvest, its deviation, area and plant totals for the farm and for every crop
+// every plot's share is kept in fixed point, so a changed plot is taken off and put back on
+// exactly and the totals never drift no matter how many edits go by
+class FarmStats {
+public:
+    // sums over some set of plots, variance is in hundredths of a lb squared
+    // which overflows 64 bits on big imported farms, so it gets 128
+    struct Totals {
+        int64_t plots;
+        int64_t area;
+        int64_t plants;
+        int64_t harvest;
+        __int128 variance;
+
+        // adds (sign 1) or takes away (sign -1) other
+        void add(const Totals& other, int sign);
+        double harvestLbs();
+        // deviations are treated as independent, so they add up as variances
+        double deviationLbs();
+    };
+
+    bool open;
+
+private:
+    // what the totals were built from
+    Farm* farm;
+    uint64_t farmVersion;
+    int registryVersion;
+    bool detailsDone;
+
+    Totals total;
+    // indexed by crop index
+    std::vector<Totals> byCrop;
+    // what each plot added and under which crop, indexed by plot id
+    std::vector<Totals> plots;
+    std::vector<int> crops;
+    // plots changed since the last refresh, kept around so a drag doesnt allocate
+    std::vector<int> changed;
+
+public:
+    FarmStats();
+
+public:
+    // draws the totals, and the per crop window when it is open
+    void show(Farm* farm, CropRegistry* registry);
+    // recounts everything on the next show, for when a different farm is shown
+    void reset();
+    // one plot's share of the totals
+    static Totals contributionOf(Plot* plot);
+
+private:
+    // brings the totals up to date with the farm, only touching plots changed since the last call
+    void refresh(Farm* farm, CropRegistry* registry);
+    void refreshPlot(Plot* plot);
+    void showCrops(CropRegistry* registry);
+};
+
+// monte carlo run of the farm's total harvest, every plot's harvest is sampled around its
+// expected harvest with its yield deviance as the standard deviation
+// runs on a worker thread that splits the trials across every core, samples are drawn from
+// a counter based generator so a seed always gives the same result
+class HarvestSimulation {
+public:
+    // what a run came up with, in lbs
+    struct Result {
+        int trials;
+        int plots;
+        double mean;
+        double deviation;
+        double p5;
+        double p50;
+        double p95;
+        double lowest;
+        double highest;
+        float histogram[SIMULATION_BINS];
+        float seconds;
+    };
+
+    bool open;
+
+    // settings for the next run, the correlation is between plots growing the same crop
+    int trials;
+    int seed;
+    float correlation;
+
+private:
+    // copied out of the farm when a run starts, indexed by plot id
+    std::vector<float> means;
+    std::vector<float> deviations;
+    std::vector<int> crops;
+    int cropCount;
+    // trials of the run and the blocks of plots by trials its work is split into, set along with the copy
+    int runTrials;
+    int workItems;
+
+    std::thread worker;
+    std::atomic<bool> cancelled;
+    std::atomic<bool> finished;
+    std::atomic<int> progress;
+
+    Result result;
+    bool hasResult;
+
+public:
+    HarvestSimulation();
+    // stops a run that is still going
+    ~HarvestSimulation();
+
+public:
+    // draws the settings and the last result
+    void show(Farm* farm, CropRegistry* registry);
+    // copies the plots and starts a run on the worker thread
+    void start(Farm* farm, CropRegistry* registry);
+    bool running();
+    // copies what a run needs out of the farm, along with the trial count
+    void snapshot(Farm* farm, CropRegistry* registry);
+    // runs every trial over the copied plots, blocking until they are done
+    // a cancelled run returns partial sums, which are no use as a result
+    Result simulate();
+};
+
+// day by day run of a growing season, every plot is planted on its crop's first planting day,
+// grows a little each day depending on the weather and is harvested and replanted once ripe
+// the plots are stepped a block at a time through the whole season, each block on whichever
+// core is free, and what happened is kept as each planting's first and last day so that any
+// day of the season can be looked up again without running anything
+class GrowthSimulation {
+public:
+    // how many plots were in each stage by the end of one day, and what came off them that day in lbs
+    struct Day {
+        int stages[GROWTH_STAGES];
+        double harvested;
+    };
+
+    bool open;
+
+    // day the timeline is at, and whether the canvas shows every plot's stage on that day
+    int day;
+    bool overlay;
+
+private:
+    // copied out of the farm when a run starts, indexed by plot id
+    // rates are the share of a crop's growth done in one day of normal weather
+    std::vector<float> rates;
+    std::vector<float> harvests;
+    std::vector<int> firstDays;
+
+    // how fast things grow on each day of the season, and the sum of it up to each day
+    float weather[GROWTH_SEASON_DAYS];
+    float grown[GROWTH_SEASON_DAYS + 1];
+
+    // what a run came up with, every plot has room for GROWTH_MAX_PLANTINGS plantings
+    // a planting that was still growing when the season ended has a harvest day of 255
+    std::vector<uint8_t> plantDays;
+    std::vector<uint8_t> harvestDays;
+    std::vector<uint8_t> plantings;
+    std::vector<Day> days;
+    float harvestCurve[GROWTH_SEASON_DAYS];
+    int plots;
+    float seconds;
+    bool hasResult;
+
+    std::thread worker;
+    std::atomic<bool> cancelled;
+    std::atomic<bool> finished;
+    std::atomic<int> progress;
+    int blocks;
+
+    // every plot's stage on the day the canvas was last drawn for
+    std::vector<uint8_t> stages;
+    int stagesDay;
+    // plots of each stage as drawn, kept between frames so drawing doesnt allocate
+    std::vector<SDL_Rect> stageRects[GROWTH_STAGES];
+
+public:
+    GrowthSimulation();
+    // stops a run that is still going
+    ~GrowthSimulation();
+
+public:
+    // draws the run button and the timeline
+    void show(Farm* farm);
+    // shades every plot by its stage on the timeline's day, over the plots already drawn
+    void render(SDL_Renderer* renderer, Farm* farm);
+    // copies the plots and starts a run on the worker thread
+    void start(Farm* farm);
+    bool running();
+    // copies what a run needs out of the farm
+    void snapshot(Farm* farm);
+    // steps every plot through the season, blocking until it is done, returns the seconds it took
+    float simulate();
+    // forgets the last run, its plot ids belong to the farm it was made from
+    void reset();
+    // a plot's stage at the end of a day, from the recorded plantings
+    int stageOf(int id, int day);
+    // counts and harvest of one day of the last run
+    Day& totalsOn(int day);
+    // total harvested up to the end of a day
+    double harvestedBy(int day);
+
+private:
+    // runs plots [begin, end) through the whole season, adding what happened into days
+    void simulateBlock(int begin, int end, Day* days, float* bases, int* next, int* planted, int* count);
+    // refreshes the stages for the timeline's day
+    void updateStages();
+};
+
+// simulated annealing runs shared by the optimizers, one chain per core each from its own seed
+// chains make their moves in batches, cooling down and reporting their score after every batch
+// so a window can draw every chain's progress while the run is going
+class Annealing {
+public:
+    // one chain's random numbers and where it is in its cooling schedule
+    struct Chain {
+        int index;
+        std::mt19937 random;
+        std::uniform_real_distribution<double> chance;
+        int64_t done;
+        double temperature;
+        double cooling;
+    };
+
+    // set from the main thread to stop every chain after its current batch
+    std::atomic<bool> cancelled;
+
+private:
+    // every chain's score at evenly spaced points of its run, the chain count only ever changes along with them
+    std::mutex lock;
+    std::vector<float> curves;
+    std::vector<int> reached;
+    int chains;
+    int64_t totalMoves;
+    std::atomic<int64_t> movesDone;
+
+    // schedule every chain follows
+    int64_t chainMoves;
+    int batchSize;
+    double startTemperature;
+    double endTemperature;
+
+public:
+    Annealing();
+
+public:
+    // sets up a run of chains that each make chainMoves moves, batchSize at a time
+    // temperatures go from hot down to cold times scale, the size of a typical move's change in score
+    void begin(int chains, int64_t chainMoves, int batchSize, double scale, double hot, double cold);
+    // runs fn on every chain across every core, fn returns the chain's final score
+    // returns the chain with the best score, ties go to the lowest so a seed always gives the same result
+    int run(int seed, const std::function<double(Chain&)>& fn);
+    // moves in the chain's next batch, 0 once it is done or the run was cancelled
+    int batch(Chain& chain);
+    // better moves always go through, worse ones less and less often as the chain cools
+    bool accept(Chain& chain, double delta);
+    // counts a finished batch, records the chain's score and cools it down for the next one
+    void report(Chain& chain, int batch, double score);
+    // temperature left as a share of the starting temperature
+    double heat(Chain& chain);
+
+    // safe to call from the main thread while a run is going
+    int chainCount();
+    // share of every chain's moves made so far
+    float progress();
+    // best score of any chain at every point all of them have reached, curve needs room for ANNEAL_CURVE points
+    // returns how many points were filled in
+    int bestCurve(float* curve);
+};
+
+// plans which crop every plot grows over the next few seasons to get the most harvest out of the farm
+// the farm's current crops count as the season before the plan, a plant family has to stay out of a
+// plot for the minimum gap after growing there and no crop can take more than its quota of plots in
+// a season, neighbors growing the same family in the same season each lose part of their harvest
+// every core runs its own simulated annealing chain from a different seed, a move changes one plot's
+// crop in one season and is scored from just that plot and its neighbors
+class RotationPlanner {
+public:
+    // crop of every plot in every season, indexed plot * seasons + season, with what it comes to in lbs
+    struct Plan {
+        int plots;
+        int seasons;
+        std::vector<uint16_t> crops;
+        std::vector<int> counts;
+        std::vector<double> seasonHarvests;
+        double harvest;
+        double penalty;
+        double score;
+        int chains;
+        float seconds;
+    };
+
+    bool open;
+
+    // settings for the next run, quotas are the most plots a crop can take in a season in percent
+    int seasons;
+    int gap;
+    float neighborPenalty;
+    int sweeps;
+    int seed;
+    std::vector<int> quotas;
+    // what the all crops slider last set every quota to
+    int allQuotas;
+
+    // season of the plan the apply button puts on the farm
+    int applySeason;
+
+private:
+    // copied out of the farm and registry when a run starts
+    // bounds and the family before the plan are per plot, yields, spacings, families and limits per crop
+    std::vector<SDL_Rect> bounds;
+    std::vector<int> previous;
+    std::vector<float> yields;
+    std::vector<int> spacings;
+    std::vector<int> families;
+    std::vector<int> limits;
+    // crops a move can pick from, every crop with a yield and a quota plus the empty crop
+    std::vector<int> candidates;
+    // plots each plot shares pests with, plot p's are neighbors[neighborStart[p]] up to neighborStart[p + 1]
+    std::vector<int> neighborStart;
+    std::vector<int> neighbors;
+    int cropCount;
+    Farm* planFarm;
+    int planRegistryVersion;
+
+    std::thread worker;
+    std::atomic<bool> finished;
+    // the chains, their cooling and their scores for the live view
+    Annealing annealing;
+
+    Plan plan;
+    bool hasResult;
+
+public:
+    RotationPlanner();
+    // stops a run that is still going
+    ~RotationPlanner();
+
+public:
+    // draws the settings, the live progress and the plan
+    void show(Farm* farm, CropRegistry* registry);
+    // copies the farm and starts a run on the worker thread
+    void start(Farm* farm, CropRegistry* registry);
+    bool running();
+    // copies what a run needs out of the farm and registry
+    void snapshot(Farm* farm, CropRegistry* registry);
+    // runs every chain and keeps the best plan, blocking until they are done
+    Plan optimize();
+    // puts one season of the plan onto the farm, undone as one step
+    void apply(Farm* farm, CropRegistry* registry, int season);
+    // forgets the last plan, its plot ids belong to the farm it was made from
+    void reset();
+    // gaps and quotas a plan breaks, 0 for any plan the optimizer comes up with
+    int violations(Plan& plan);
+
+private:
+    // finds the plots near each plot with a grid over the farm
+    void findNeighbors(Farm* farm);
+    // harvest of one plot planted with one crop, how many plants fit depends on the crop
+    double harvestOf(int plot, int crop);
+    // change in score from giving a plot a crop in one season, false if that breaks a gap or quota
+    bool moveDelta(const uint16_t* crops, const int* counts, int plot, int season, int crop, double* delta);
+    // one annealing chain from an empty plan
+    void anneal(Annealing::Chain& chain, Plan* plan);
+    // fills in a plan's counts and totals from its crops
+    void evaluate(Plan* plan);
+    void showQuotas(CropRegistry* registry);
+};
+
+// moves, resizes and replants every plot so the field holds the most expected harvest
+// plots have to stay inside the field, clear of the obstacles and spacing apart from each other,
+// and a crop's harvest only counts up to its target share of the field, if it has one
+// every core runs its own simulated annealing chain from a different seed, each with a grid of
+// what is where so a placement is checked against only the plots and obstacles near it
+class LayoutOptimizer {
+public:
+    // every plot's rect and crop, plots that didnt fit anywhere in the field arent placed
+    struct Layout {
+        std::vector<SDL_Rect> rects;
+        std::vector<int> crops;
+        std::vector<uint8_t> placed;
+        double harvest;
+        int placedCount;
+        int chains;
+        float seconds;
+    };
+
+    // buckets of ids by the cells their rects cover
+    struct Grid {
+        SDL_Rect area;
+        int cell;
+        int columns;
+        int rows;
+        std::vector<std::vector<int>> cells;
+
+        void reset(SDL_Rect area, int cell);
+        void insert(int id, SDL_Rect rect);
+        void remove(int id, SDL_Rect rect);
+        // true if rect comes within spacing of anything other than ignore, rects holds every id's rect
+        bool blocked(SDL_Rect rect, int spacing, int ignore, const std::vector<SDL_Rect>& rects);
+    };
+
+    bool open;
+
+    // settings for the next run, targets are each crop's share of the field in percent, 0 for no target
+    SDL_Rect field;
+    std::vector<SDL_Rect> obstacles;
+    int spacing;
+    int sweeps;
+    int seed;
+    bool changeCrops;
+    std::vector<int> targets;
+    // what the all crops slider last set every target to
+    int allTargets;
+
+private:
+    // copied out of the farm and registry when a run starts
+    // the first plots rects are the plots as they are, the rest are the obstacles
+    std::vector<SDL_Rect> startRects;
+    std::vector<int> startCrops;
+    std::vector<uint8_t> startPlaced;
+    std::vector<float> yields;
+    std::vector<int> spacings;
+    std::vector<int64_t> targetAreas;
+    std::vector<int> candidates;
+    int plots;
+    int cell;
+    // harvest of the plots that fit the field where they already are
+    double startHarvest;
+    Farm* planFarm;
+    int planRegistryVersion;
+
+    std::thread worker;
+    std::atomic<bool> finished;
+    // the chains, their cooling and their harvests for the live view
+    Annealing annealing;
+
+    Layout layout;
+    bool hasResult;
+
+public:
+    LayoutOptimizer();
+    // stops a run that is still going
+    ~LayoutOptimizer();
+
+public:
+    // draws the settings, the live progress and the result
+    void show(Farm* farm, CropRegistry* registry);
+    // outlines the field and shades the obstacles on the canvas
+    void render(SDL_Renderer* renderer);
+    // copies the farm and starts a run on the worker thread
+    void start(Farm* farm, CropRegistry* registry);
+    bool running();
+    // copies what a run needs out of the farm and registry
+    void snapshot(Farm* farm, CropRegistry* registry);
+    // runs every chain and keeps the best layout, blocking until they are done
+    Layout optimize();
+    // puts the layout onto the farm as one undo step, plots that didnt fit are lined up under the field
+    void apply(Farm* farm, CropRegistry* registry);
+    // forgets the last layout, its plot ids belong to the farm it was made from
+    void reset();
+    // field to the box around every plot
+    void fitField(Farm* farm);
+    // placed plots that leave the field, get too close to each other or touch an obstacle
+    int conflicts(Layout& layout);
+
+private:
+    // harvest a crop's plots count for, cut back once they cover more than its target area
+    double valueOf(int crop, int64_t plants, int64_t area);
+    // one annealing chain from the farm as it is
+    void anneal(Annealing::Chain& chain, Layout* layout);
+    void showTargets(CropRegistry* registry);
+    void showField(Farm* farm);
+};
+
+// overlay shading every plot along a color ramp by yield per area, deviation or risk
+// the canvas is a streaming texture, and only plots changed since the last frame are recomputed and repainted
+// plots never overlap, so a plot's pixels are only ever its own
+class Heatmap {
+public:
+    bool open;
+    int metric;
+    float opacity;
+
+private:
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;
+    std::vector<uint32_t> pixels;
+
+    // metric and ramp color of every plot, and the part of the canvas it was painted on, indexed by plot id
+    std::vector<float> values;
+    std::vector<uint32_t> colors;
+    std::vector<SDL_Rect> paintedRects;
+    // the ramp runs from nothing to the highest value on the farm
+    float highest;
+
+    // what the pixels were made from, and the part of them the texture doesnt have yet
+    Farm* farm;
+    uint64_t farmVersion;
+    int registryVersion;
+    bool detailsDone;
+    int paintedMetric;
+    SDL_Rect dirty;
+    // plots changed since the last refresh, kept around so a drag doesnt allocate
+    std::vector<int> changed;
+
+public:
+    Heatmap(SDL_Renderer* renderer);
+    ~Heatmap();
+
+public:
+    // draws the settings and the legend
+    void show();
+    // draws the overlay over the plots
+    void render(Farm* farm, CropRegistry* registry);
+    // brings the values and pixels up to date with the farm, only touching plots changed since the last call
+    void refresh(Farm* farm, CropRegistry* registry);
+    // rebuilds everything on the next refresh, for when a different farm is shown
+    void reset();
+    // makes the texture again on the next render, for when the renderer lost its textures
+    void invalidate();
+    // highest value the ramp is scaled to, in the units of the metric
+    float scaleTop();
+
+private:
+    float valueOf(Plot* plot);
+    // colors every plot again and paints the whole canvas
+    void repaint(Farm* farm);
+    // fills the visible part of rect with color, and grows the dirty area over it
+    SDL_Rect paint(SDL_Rect rect, uint32_t color);
+};
+
+// every plant of every plot, sitting on the plot's lattice at its crop's spacing
+// plants are a byte each, so millions of them take a few megabytes and a pass over them goes 8 at a time
+class PlantStore {
+public:
+    bool open;
+    // share of seeds that come up in percent, and the seed deciding which ones
+    int emergence;
+    int seed;
+
+private:
+    // a plot's plants are one run of the buffer, row by row, a plot that outgrows its run gets a new one at the end
+    std::vector<uint8_t> states;
+    std::vector<int64_t> starts;
+    std::vector<int> capacities;
+    // lattice, live plants and yield of every plot, indexed by plot id
+    std::vector<int> columns;
+    std::vector<int> counts;
+    std::vector<int> alive;
+    std::vector<float> yields;
+
+    // totals over the whole farm
+    int64_t plantTotal;
+    int64_t aliveTotal;
+    double harvest;
+
+    // what the plants were sown from
+    Farm* farm;
+    uint64_t farmVersion;
+    int registryVersion;
+    int sownEmergence;
+    int sownSeed;
+    // plots changed since the last refresh, and the plants on screen, kept around so a frame doesnt allocate
+    std::vector<int> changed;
+    std::vector<SDL_Point> aliveDots;
+    std::vector<SDL_Point> deadDots;
+
+public:
+    PlantStore();
+
+public:
+    // draws the settings and the plant totals
+    void show(Farm* farm, CropRegistry* registry);
+    // draws a dot for every plant on screen, dead ones in another color
+    void render(SDL_Renderer* renderer, Farm* farm, CropRegistry* registry);
+    // brings the plants up to date with the farm, only sowing plots changed since the last call
+    void refresh(Farm* farm, CropRegistry* registry);
+    // sows everything again on the next refresh, for when a different farm is shown
+    void reset();
+    // plants of one plot, row by row, Plot::plantColumns of them a row
+    const uint8_t* plantsOf(int plot);
+
+    int64_t plants();
+    int64_t living();
+    // live plants times their plot's expected yield
+    double liveHarvest();
+    // bytes the buffer holds, counting space left behind by runs that moved or shrank
+    size_t bytes();
+
+private:
+    // gives a plot a run with room for its plants, moving it to the end if it doesnt fit where it is
+    void place(int plot, int count);
+    // rolls every plant of a plot and counts the ones that came up, plots sow in parallel since runs never overlap
+    void sow(int plot, Plot* source);
+    // copies every run to a new buffer with no gaps between them
+    void compact();
+};
+
+// evaluates what-if variants of a farm without ever opening a window, this is what the batch binary runs
+// scenarios come one json object a line, and every line gets a csv row in the same order
+class ScenarioBatch {
+public:
+    // one line of the scenario file with every name already looked up
+    struct Scenario {
+        std::string name;
+        // crop every plot is switched to, -1 keeps the farm's crops
+        int crop;
+        // plot id and crop index, plot id and deviance in percent, crop index and yield in lbs/plant
+        // all sorted by their first field
+        std::vector<std::pair<int, int>> plotCrops;
+        std::vector<std::pair<int, float>> deviances;
+        std::vector<std::pair<int, double>> yields;
+        // every plot's deviance is multiplied by this
+        double devianceScale;
+        // crops and plots named in the line that dont exist
+        int unknown;
+        // empty unless the line couldnt be used at all
+        std::string error;
+    };
+
+    struct Result {
+        int64_t plants;
+        double harvest;
+        double deviation;
+        // 5th and 95th percentile harvests, taking the total as normally distributed
+        double low;
+        double high;
+    };
+
+private:
+    CropRegistry* registry;
+    std::vector<Plot*> plots;
+    // plot ids by name, several plots can share a name
+    std::unordered_map<std::string, std::vector<int>> plotsByName;
+
+    // every plot as the farm has it
+    std::vector<SDL_Rect> bounds;
+    std::vector<int> crops;
+    std::vector<float> deviances;
+
+    // plants and spread of every crop's plots, and of the whole farm with that crop planted everywhere
+    // spread is the sum of (plants * deviance)^2, a crop's variance in lbs is its yield squared times its spread
+    std::vector<int64_t> cropPlants;
+    std::vector<double> cropSpread;
+    std::vector<int64_t> everywherePlants;
+    std::vector<double> everywhereSpread;
+    std::vector<double> yields;
+    std::vector<int> spacings;
+
+public:
+    ScenarioBatch(CropRegistry* registry);
+    ~ScenarioBatch();
+
+public:
+    // loads every plot with its details from the farm's json, nothing is ever written back
+    bool loadFarm(std::string filename);
+    // evaluates every line of the scenario file and streams the results to a csv, returns the exit code
+    int run(std::string scenarioFile, std::string outputFile);
+    // parses one line, every thread passes its own reader
+    Scenario parse(const std::string& line, Json::CharReader* reader);
+    // yield totals of one scenario, plants and spread are scratch space reused between calls
+    Result evaluate(Scenario& scenario, std::vector<int64_t>& plants, std::vector<double>& spread);
+
+private:
+    // plants of one plot if it had this crop, the crop's spacing decides how many fit
+    int64_t plantsOf(int plot, int crop);
+};
+
+// plots with their config window open, in the order they were opened
+// there are only ever a few, so everything here is a walk over the list instead of over every plot
+class PlotWindows {
+public:
+    struct Window {
+        Plot* plot;
+        // pinned windows stay open when another plot's window is opened
+        bool pinned;
+    };
+
+    std::vector<Window> windows;
+
+public:
+    // opens a plot's window, closing every other one that isnt pinned
+    void open(Plot* plot);
+    void close(Plot* plot);
+    // right clicking a plot opens its window, or closes it if it was already open
+    void toggle(Plot* plot);
+    bool isOpen(Plot* plot);
+    // closes everything, for when a different farm is shown
+    void clear();
+};
+
+// finds plots whose name or crop matches what was typed
+// names go into a SearchIndex, plots renamed after it was built are checked by hand instead
+// of rebuilding it on every keystroke, until there are enough of them to be worth a rebuild
+class PlotSearch {
+private:
+    // what the index was built from
+    Farm* farm;
+    uint64_t farmVersion;
+    int registryVersion;
+    bool detailsDone;
+
+    // plot names as of the last build, and the crop index of every plot
+    SearchIndex index;
+    std::vector<int> crops;
+
+    // sorted ids of plots whose name changed since the build, with their new lowercased names
+    std::vector<int> stale;
+    std::vector<std::string> staleNames;
+    std::vector<char> staleMark;
+
+    // what was typed, lowercased
+    char buffer[128];
+    std::string text;
+    SearchQuery nameQuery;
+
+    // matching ids in ascending order
+    std::vector<int> results;
+    bool resultsDirty;
+
+    // reused by every search, and plots changed since the last refresh
+    std::vector<int> changed;
+    std::vector<int> named;
+    std::vector<int> cropHits;
+    std::vector<char> cropMark;
+    std::vector<int> cropPlots;
+
+public:
+    PlotSearch();
+
+public:
+    // draws the search box and its matches, picking one opens its config window
+    void show(Farm* farm, CropRegistry* registry, PlotWindows* windows);
+    // rebuilds the index on the next search, for when a different farm is shown
+    void reset();
+    // every matching plot id
+    std::vector<int>& matches();
+
+private:
+    // brings the index up to date with the farm, only touching plots changed since the last call
+    void refresh(Farm* farm, CropRegistry* registry);
+    void rebuild(Farm* farm);
+    void refreshPlot(Plot* plot);
+    // runs the query again if it or the plots changed
+    void search(CropRegistry* registry);
+};
+
+// counts heap allocations made through operator new, imgui and sdl
+// only compiled in with ALLOC_TRACKING, otherwise every count stays at zero
+class AllocTracker {
+public:
+    // allocations made by one thread
+    struct Counts {
+        uint64_t news;
+        uint64_t imgui;
+        uint64_t sdl;
+        uint64_t bytes;
+
+        uint64_t total();
+    };
+
+public:
+    // points imgui and sdl at the counting allocators, has to run before either of them allocates
+    static void install();
+    // true when the counting is compiled in
+    static bool enabled();
+    // the calling thread's counts so far
+    static Counts current();
+    // what the calling thread allocated since start was taken
+    static Counts since(Counts start);
+};
+
+// tokenizes memory mapped csv text with the simd delimiter scan, shared by the csv loaders
+class CsvScanner {
+public:
+    // trimmed column names from the first line, body is set to where the rows start
+    static std::vector<std::string> header(const char* data, const char* end, const char** body);
+    // splits [begin, end) into chunks for each core to parse, every chunk starts at the beginning of a line
+    static std::vector<const char*> chunks(const char* begin, const char* end);
+    // calls row with the trimmed fields of every line in [begin, end), which has to start at the beginning of a line
+    // the fields point into the buffer and are only valid during the call
+    static void rows(const char* begin, const char* end, const std::function<void(std::vector<std::string_view>&)>& row);
+};
+
+// plot ids bucketed by the cells of a grid over a farm, built once and then only read, so any thread can use it
+// cells are about the size of an average plot so most plots only land in a few, and the buckets are two
+// flat arrays, the ids in cell c are ids[starts[c]] up to ids[starts[c + 1]]
+class PlotGrid {
+public:
+    SDL_Rect extent;
+    int cell;
+    int columns;
+    int rows;
+    std::vector<int> starts;
+    std::vector<int> ids;
+
+public:
+    // every plot goes in every cell its bounds, grown by margin on each side, touch
+    void build(const std::vector<Plot*>& plots, int margin);
+    // cell a point inside the extent is in
+    int cellOf(int x, int y);
+
+    // calls fn with every cell rect touches, the parts of rect outside the extent are left out
+    template <typename Fn>
+    void forCells(SDL_Rect rect, Fn fn) {
+        int firstX = std::max(0, (rect.x - this->extent.x) / this->cell);
+        int firstY = std::max(0, (rect.y - this->extent.y) / this->cell);
+        int lastX = std::min(this->columns - 1, (rect.x + rect.w - 1 - this->extent.x) / this->cell);
+        int lastY = std::min(this->rows - 1, (rect.y + rect.h - 1 - this->extent.y) / this->cell);
+        for (int y = firstY; y <= lastY; y++) {
+            for (int x = firstX; x <= lastX; x++) {
+                fn(y * this->columns + x);
+            }
+        }
+    }
+};
+
+// splitting loops up across every core
+class Parallel {
+public:
+    // number of threads work gets split across
+    static int workerCount();
+    // calls fn(begin, end) over blocks of [0, count), blocks are handed out to whichever thread is free
+    static void forRange(int count, int blockSize, std::function<void(int, int)> fn);
+};
+
+// background saving of changed plots
+// the main thread only hands over the records that changed, the worker keeps its own copy
+// of the whole farm and writes it out once no changes have come in for the debounce interval
+class Autosave {
+private:
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+
+    // shared with the main thread, always accessed under lock
+    bool stopping;
+    bool seeded;
+    std::vector<PlotRecord> seedRecords;
+    std::unordered_map<int, PlotRecord> pending;
+    std::string pendingName;
+    bool nameChanged;
+    std::chrono::steady_clock::time_point lastChange;
+    int debounceMs;
+    // flushes asked for and written, a flush skips the debounce and writes even with nothing changed
+    std::condition_variable flushed;
+    int flushRequested;
+    int flushWritten;
+    bool flushGood;
+    // set once the farm should never be written again, changes are still taken but dropped
+    bool discarded;
+
+    // only ever touched by the worker
+    std::string filename;
+    std::string farmName;
+    std::vector<PlotRecord> mirror;
+
+public:
+    // statistics for the performance display
+    std::atomic<int> writeCount;
+    std::atomic<float> lastWriteMs;
+
+public:
+    Autosave(std::string filename, int debounceMs);
+    // writes any remaining changes and stops the worker
+    ~Autosave();
+
+public:
+    // give the worker the full farm, nothing is written before this happens
+    void seed(std::string farmName, std::vector<PlotRecord>& records);
+    // queue changed plots, replaces older queued versions of the same plot
+    void submit(std::vector<PlotRecord>& records);
+    // queue a new farm name
+    void submitName(std::string name);
+    // change how long the farm has to be idle before writing
+    void setDebounce(int ms);
+    // writes everything queued so far right away on the worker, blocking until it is on disk
+    // returns false if the write failed, or if the farm was never seeded or was discarded
+    bool flush();
+    // drops everything queued and never writes again, for farms that only live in memory
+    void discard();
+
+private:
+    // worker thread loop
+    void run();
 };
\ No newline at end of file
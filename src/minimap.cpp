@@ -0,0 +1,235 @@
+/*
+ *  minimap.cpp - low resolution overview of the whole farm
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+Minimap::Minimap(SDL_Renderer* renderer) {
+    this->renderer = renderer;
+    this->texture = nullptr;
+    this->width = 0;
+    this->height = 0;
+    this->scale = 1;
+    this->world = {0, 0, 0, 0};
+    this->dirty = {0, 0, 0, 0};
+    this->farm = nullptr;
+    this->farmVersion = 0;
+    this->registryVersion = -1;
+}
+
+Minimap::~Minimap() {
+    if (this->texture) {
+        SDL_DestroyTexture(this->texture);
+    }
+}
+
+void Minimap::reset() {
+    this->farm = nullptr;
+}
+
+// adds (sign 1) or takes away (sign -1) a plot's color from every texel it covers
+// each texel keeps color sums weighted by how much of it the plot covers, so this is exact either way
+void Minimap::splat(SDL_Rect rect, SDL_Color color, int sign) {
+    // plot corners in world units relative to the corner of the map
+    int left = rect.x - this->world.x;
+    int top = rect.y - this->world.y;
+    int right = left + rect.w;
+    int bottom = top + rect.h;
+
+    int firstX = std::max(left / this->scale, 0);
+    int firstY = std::max(top / this->scale, 0);
+    int lastX = std::min((right - 1) / this->scale, this->width - 1);
+    int lastY = std::min((bottom - 1) / this->scale, this->height - 1);
+    if (rect.w <= 0 || rect.h <= 0 || firstX > lastX || firstY > lastY) {
+        return;
+    }
+
+    for (int y = firstY; y <= lastY; y++) {
+        int coverY = std::min(bottom, (y + 1) * this->scale) - std::max(top, y * this->scale);
+
+        for (int x = firstX; x <= lastX; x++) {
+            int coverX = std::min(right, (x + 1) * this->scale) - std::max(left, x * this->scale);
+            int64_t weight = (int64_t) coverX * coverY * sign;
+
+            int64_t* texel = &this->sums[(y * this->width + x) * 4];
+            texel[0] += weight * color.r;
+            texel[1] += weight * color.g;
+            texel[2] += weight * color.b;
+            texel[3] += weight;
+        }
+    }
+
+    SDL_Rect touched = {firstX, firstY, lastX - firstX + 1, lastY - firstY + 1};
+    if (SDL_RectEmpty(&this->dirty)) {
+        this->dirty = touched;
+    } else {
+        SDL_UnionRect(&this->dirty, &touched, &this->dirty);
+    }
+}
+
+// turns the sums of the dirty texels into pixels, blending with the background by how covered they are
+void Minimap::shade() {
+    int64_t area = (int64_t) this->scale * this->scale;
+
+    for (int y = this->dirty.y; y < this->dirty.y + this->dirty.h; y++) {
+        for (int x = this->dirty.x; x < this->dirty.x + this->dirty.w; x++) {
+            int64_t* texel = &this->sums[(y * this->width + x) * 4];
+            int red = MINIMAP_BACKGROUND;
+            int green = MINIMAP_BACKGROUND;
+            int blue = MINIMAP_BACKGROUND;
+
+            if (texel[3] > 0) {
+                int64_t covered = std::min(texel[3], area);
+                red = (texel[0] / texel[3] * covered + MINIMAP_BACKGROUND * (area - covered)) / area;
+                green = (texel[1] / texel[3] * covered + MINIMAP_BACKGROUND * (area - covered)) / area;
+                blue = (texel[2] / texel[3] * covered + MINIMAP_BACKGROUND * (area - covered)) / area;
+            }
+
+            // RGBA32 is r, g, b, a in memory whatever the byte order
+            uint8_t* pixel = (uint8_t*) &this->pixels[y * this->width + x];
+            pixel[0] = red;
+            pixel[1] = green;
+            pixel[2] = blue;
+            pixel[3] = 0xFF;
+        }
+    }
+}
+
+void Minimap::rebuild(Farm* farm) {
+    // the map covers every plot and the window, with some room to move things around
+    SDL_Rect extent = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    for (auto& plot : farm->plots) {
+        SDL_UnionRect(&extent, &plot->bounds, &extent);
+    }
+
+    int margin = std::max(extent.w, extent.h) / 8;
+    this->world = {extent.x - margin, extent.y - margin, extent.w + margin * 2, extent.h + margin * 2};
+
+    // whole world units per texel keep every texel edge on an integer, so the weights are exact
+    this->scale = std::max(1, std::max((this->world.w + MINIMAP_SIZE - 1) / MINIMAP_SIZE, (this->world.h + MINIMAP_SIZE - 1) / MINIMAP_SIZE));
+    int width = std::max(1, (this->world.w + this->scale - 1) / this->scale);
+    int height = std::max(1, (this->world.h + this->scale - 1) / this->scale);
+
+    if (this->texture == nullptr || width != this->width || height != this->height) {
+        if (this->texture) {
+            SDL_DestroyTexture(this->texture);
+        }
+
+        this->texture = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, width, height);
+        this->width = width;
+        this->height = height;
+    }
+
+    this->sums.assign(this->width * this->height * 4, 0);
+    this->pixels.assign(this->width * this->height, 0);
+    this->drawnRects.resize(farm->plots.size());
+    this->drawnColors.resize(farm->plots.size());
+
+    for (auto& plot : farm->plots) {
+        plot->syncCrop();
+        this->drawnRects[plot->id] = plot->bounds;
+        this->drawnColors[plot->id] = plot->crop->color;
+        this->splat(plot->bounds, plot->crop->color, 1);
+    }
+
+    this->dirty = {0, 0, this->width, this->height};
+}
+
+// moves one plot on the map, returns false if it left the area the map covers
+bool Minimap::update(Plot* plot) {
+    SDL_Rect& drawn = this->drawnRects[plot->id];
+    SDL_Color& color = this->drawnColors[plot->id];
+    if (SDL_RectEquals(&drawn, &plot->bounds) && memcmp(&color, &plot->crop->color, sizeof(color)) == 0) {
+        return true;
+    }
+
+    SDL_Rect inside;
+    if (!SDL_IntersectRect(&plot->bounds, &this->world, &inside) || !SDL_RectEquals(&inside, &plot->bounds)) {
+        return false;
+    }
+
+    this->splat(drawn, color, -1);
+    drawn = plot->bounds;
+    color = plot->crop->color;
+    this->splat(drawn, color, 1);
+    return true;
+}
+
+void Minimap::refresh(Farm* farm, CropRegistry* registry) {
+    // a different farm or reloaded crop colors touch everything
+    bool full = farm != this->farm || registry->version != this->registryVersion;
+
+    if (!full && farm->version != this->farmVersion) {
+        // plots added since the last refresh go straight on the map
+        for (int id = this->drawnRects.size(); id < (int) farm->plots.size() && !full; id++) {
+            this->drawnRects.push_back({0, 0, 0, 0});
+            this->drawnColors.push_back(farm->plots[id]->crop->color);
+            full = !this->update(farm->plots[id]);
+        }
+
+        this->changed.clear();
+        farm->changedSince(this->farmVersion, &this->changed);
+        for (int i = 0; i < (int) this->changed.size() && !full; i++) {
+            full = !this->update(farm->plots[this->changed[i]]);
+        }
+    }
+
+    if (full) {
+        this->rebuild(farm);
+        this->farm = farm;
+        this->registryVersion = registry->version;
+    }
+    this->farmVersion = farm->version;
+
+    // only the texels that changed are sent to the gpu
+    if (!SDL_RectEmpty(&this->dirty)) {
+        this->shade();
+        SDL_UpdateTexture(this->texture, &this->dirty, &this->pixels[this->dirty.y * this->width + this->dirty.x], this->width * sizeof(uint32_t));
+        this->dirty = {0, 0, 0, 0};
+    }
+}
+
+void Minimap::invalidate() {
+    // a device reset can take the texture with it, so it is made again along with everything on it
+    if (this->texture) {
+        SDL_DestroyTexture(this->texture);
+        this->texture = nullptr;
+    }
+    this->farm = nullptr;
+}
+
+void Minimap::show(Farm* farm, CropRegistry* registry, PlotWindows* windows) {
+    this->refresh(farm, registry);
+
+    // fits the panel's width without taking too much of its height
+    float displayScale = std::min(ImGui::GetContentRegionAvail().x / this->width, (float) MINIMAP_DISPLAY_HEIGHT / this->height);
+    ImVec2 size = ImVec2(this->width * displayScale, this->height * displayScale);
+    ImVec2 corner = ImGui::GetCursorScreenPos();
+
+    ImGui::Image((ImTextureID) (intptr_t) this->texture, size);
+
+    // outline of what the window shows
+    auto toScreen = [&](int x, int y) {
+        return ImVec2(corner.x + (x - this->world.x) * displayScale / this->scale, corner.y + (y - this->world.y) * displayScale / this->scale);
+    };
+    ImGui::GetWindowDrawList()->AddRect(toScreen(0, 0), toScreen(WINDOW_WIDTH, WINDOW_HEIGHT), IM_COL32(255, 255, 255, 160));
+
+    if (!ImGui::IsItemClicked(ImGuiMouseButton_Left)) {
+        return;
+    }
+
+    // back to world units, then whichever plot is under that point
+    ImVec2 mouse = ImGui::GetMousePos();
+    SDL_Point point = {
+        this->world.x + (int) ((mouse.x - corner.x) / displayScale * this->scale),
+        this->world.y + (int) ((mouse.y - corner.y) / displayScale * this->scale)
+    };
+
+    for (auto& plot : farm->plots) {
+        if (SDL_PointInRect(&point, &plot->bounds)) {
+            windows->open(plot);
+            return;
+        }
+    }
+}
@@ -0,0 +1,291 @@
+/*
+ *  montecarlo.cpp - monte carlo harvest simulation from every plot's yield deviance
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// lanes the sampling loop is written in, wide enough for the compiler to turn into vector code
+#define SIMULATION_LANES 8
+
+// stream constants, the plot and crop samples of a trial come from different streams
+#define SIMULATION_TRIAL_KEY 0x9E3779B97F4A7C15ull
+#define SIMULATION_PLOT_KEY 0xD1B54A32D192ED03ull
+#define SIMULATION_CROP_KEY 0xA0761D6478BD642Full
+
+// splitmix64 finalizer, turns a counter into 64 well mixed bits
+// every sample is a function of (seed, trial, plot), so runs repeat exactly whatever the thread count
+static inline uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+// close to standard normal sample from 64 random bits, the sum of four 16 bit uniforms
+// it has no tails past 3.5 deviations, which also keeps yields from swinging wildly negative
+static inline float normalFrom(uint64_t bits) {
+    uint32_t sum = (bits & 0xFFFF) + ((bits >> 16) & 0xFFFF) + ((bits >> 32) & 0xFFFF) + (bits >> 48);
+    return ((sum + 2.0f) * (1.0f / 65536.0f) - 2.0f) * 1.7320508f;
+}
+
+// total harvest of plots [begin, end) in one trial
+// correlated runs mix each plot's own sample with one shared by every plot of the same crop
+template <bool correlated>
+static double sampleBlock(const float* means, const float* deviations, const int* crops, const float* shocks,
+    uint64_t key, int begin, int end, float own, float shared) {
+    float lanes[SIMULATION_LANES] = {};
+
+    int i = begin;
+    for (; i + SIMULATION_LANES <= end; i += SIMULATION_LANES) {
+        for (int lane = 0; lane < SIMULATION_LANES; lane++) {
+            int plot = i + lane;
+            float z = normalFrom(mix(key + plot * SIMULATION_PLOT_KEY));
+            if (correlated) {
+                z = own * z + shared * shocks[crops[plot]];
+            }
+
+            // a harvest cant go below nothing
+            float harvest = means[plot] + deviations[plot] * z;
+            lanes[lane] += harvest > 0.0f ? harvest : 0.0f;
+        }
+    }
+
+    double total = 0.0;
+    for (; i < end; i++) {
+        float z = normalFrom(mix(key + i * SIMULATION_PLOT_KEY));
+        if (correlated) {
+            z = own * z + shared * shocks[crops[i]];
+        }
+        float harvest = means[i] + deviations[i] * z;
+        total += harvest > 0.0f ? harvest : 0.0f;
+    }
+
+    for (float lane : lanes) {
+        total += lane;
+    }
+    return total;
+}
+
+HarvestSimulation::HarvestSimulation() {
+    this->open = false;
+    this->trials = 1000;
+    this->seed = 1;
+    this->correlation = 0.0f;
+    this->cropCount = 0;
+    this->runTrials = 0;
+    this->cancelled = false;
+    this->finished = false;
+    this->progress = 0;
+    this->workItems = 1;
+    this->hasResult = false;
+    this->result = {};
+}
+
+HarvestSimulation::~HarvestSimulation() {
+    this->cancelled = true;
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+}
+
+void HarvestSimulation::snapshot(Farm* farm, CropRegistry* registry) {
+    int count = farm->plots.size();
+    this->means.resize(count);
+    this->deviations.resize(count);
+    this->crops.resize(count);
+    this->cropCount = registry->ordered.size();
+
+    // deviance is a percentage of the plot's expected harvest
+    for (auto& plot : farm->plots) {
+        double harvest = plot->expectedHarvest();
+        this->means[plot->id] = harvest;
+        this->deviations[plot->id] = plot->hasDetails() ? harvest * plot->yieldDeviance / 100.0 : 0.0;
+        this->crops[plot->id] = plot->crop->index;
+    }
+
+    // the progress bar divides by this while the worker runs, so it is worked out before it starts
+    int plotBlocks = std::max(1, (count + SIMULATION_PLOT_BLOCK - 1) / SIMULATION_PLOT_BLOCK);
+    this->runTrials = this->trials;
+    this->workItems = plotBlocks * ((this->runTrials + SIMULATION_TRIAL_BLOCK - 1) / SIMULATION_TRIAL_BLOCK);
+}
+
+void HarvestSimulation::start(Farm* farm, CropRegistry* registry) {
+    if (this->running()) {
+        return;
+    }
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+
+    this->snapshot(farm, registry);
+    this->cancelled = false;
+    this->finished = false;
+    this->progress = 0;
+    this->worker = std::thread([this]() {
+        // a cancelled run only has partial sums, so the last finished result stays
+        Result result = this->simulate();
+        if (!this->cancelled) {
+            this->result = result;
+        }
+        this->finished = true;
+    });
+}
+
+bool HarvestSimulation::running() {
+    return this->worker.joinable() && !this->finished;
+}
+
+HarvestSimulation::Result HarvestSimulation::simulate() {
+    auto start = std::chrono::steady_clock::now();
+
+    int plotCount = this->means.size();
+    int trials = this->runTrials;
+    bool correlated = this->correlation > 0.0f;
+    float own = sqrt(1.0f - this->correlation);
+    float shared = sqrt(this->correlation);
+
+    // work is split both ways, so a small farm still spreads its trials across every core
+    int plotBlocks = std::max(1, (plotCount + SIMULATION_PLOT_BLOCK - 1) / SIMULATION_PLOT_BLOCK);
+    int trialBlocks = (trials + SIMULATION_TRIAL_BLOCK - 1) / SIMULATION_TRIAL_BLOCK;
+
+    // one shared sample per crop per trial
+    std::vector<float> shocks;
+    if (correlated) {
+        shocks.resize((size_t) trials * this->cropCount);
+        for (int trial = 0; trial < trials; trial++) {
+            uint64_t key = mix(this->seed * SIMULATION_TRIAL_KEY + trial) ^ SIMULATION_CROP_KEY;
+            for (int crop = 0; crop < this->cropCount; crop++) {
+                shocks[(size_t) trial * this->cropCount + crop] = normalFrom(mix(key + crop * SIMULATION_PLOT_KEY));
+            }
+        }
+    }
+
+    // every block of plots writes its own partial sums, they are added up in block order afterwards
+    // so the totals come out the same no matter which thread did what
+    std::vector<double> partials((size_t) plotBlocks * trials);
+    Parallel::forRange(this->workItems, 1, [&](int begin, int end) {
+        for (int item = begin; item < end && !this->cancelled; item++) {
+            int plotBlock = item / trialBlocks;
+            int firstPlot = plotBlock * SIMULATION_PLOT_BLOCK;
+            int lastPlot = std::min(firstPlot + SIMULATION_PLOT_BLOCK, plotCount);
+            int firstTrial = (item % trialBlocks) * SIMULATION_TRIAL_BLOCK;
+            int lastTrial = std::min(firstTrial + SIMULATION_TRIAL_BLOCK, trials);
+
+            for (int trial = firstTrial; trial < lastTrial; trial++) {
+                uint64_t key = mix(this->seed * SIMULATION_TRIAL_KEY + trial);
+                const float* shock = correlated ? &shocks[(size_t) trial * this->cropCount] : nullptr;
+
+                partials[(size_t) plotBlock * trials + trial] = correlated ?
+                    sampleBlock<true>(this->means.data(), this->deviations.data(), this->crops.data(), shock, key, firstPlot, lastPlot, own, shared) :
+                    sampleBlock<false>(this->means.data(), this->deviations.data(), this->crops.data(), shock, key, firstPlot, lastPlot, own, shared);
+            }
+
+            this->progress++;
+        }
+    });
+
+    std::vector<double> totals(trials, 0.0);
+    for (int block = 0; block < plotBlocks; block++) {
+        for (int trial = 0; trial < trials; trial++) {
+            totals[trial] += partials[(size_t) block * trials + trial];
+        }
+    }
+
+    Result result = {};
+    result.trials = trials;
+    result.plots = plotCount;
+
+    double sum = 0.0;
+    for (double total : totals) {
+        sum += total;
+    }
+    result.mean = sum / trials;
+
+    double squares = 0.0;
+    for (double total : totals) {
+        squares += (total - result.mean) * (total - result.mean);
+    }
+    result.deviation = trials > 1 ? sqrt(squares / (trials - 1)) : 0.0;
+
+    std::sort(totals.begin(), totals.end());
+    auto percentile = [&](double p) {
+        return totals[std::min(trials - 1, (int) (p * trials))];
+    };
+    result.p5 = percentile(0.05);
+    result.p50 = percentile(0.50);
+    result.p95 = percentile(0.95);
+    result.lowest = totals.front();
+    result.highest = totals.back();
+
+    double width = (result.highest - result.lowest) / SIMULATION_BINS;
+    for (double total : totals) {
+        int bin = width > 0.0 ? std::min(SIMULATION_BINS - 1, (int) ((total - result.lowest) / width)) : 0;
+        result.histogram[bin]++;
+    }
+
+    result.seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void HarvestSimulation::show(Farm* farm, CropRegistry* registry) {
+    ImGui::SetNextWindowSize(ImVec2(420, 380), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Harvest Simulation", &this->open)) {
+        ImGui::End();
+        return;
+    }
+
+    // the finished worker is picked up here, a cancelled run leaves the last result up
+    if (this->finished && this->worker.joinable()) {
+        this->worker.join();
+        this->hasResult |= !this->cancelled;
+    }
+
+    bool busy = this->running();
+    bool loading = farm->detailLoader != nullptr && !farm->detailLoader->done();
+
+    ImGui::BeginDisabled(busy);
+    ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.5);
+    ImGui::SliderInt("Trials", &this->trials, 100, SIMULATION_MAX_TRIALS, "%d", ImGuiSliderFlags_Logarithmic);
+    ImGui::InputInt("Seed", &this->seed);
+    ImGui::SliderFloat("Same Crop Correlation", &this->correlation, 0.0f, 1.0f, "%.2f");
+    ImGui::PopItemWidth();
+    ImGui::EndDisabled();
+
+    // every deviation has to be in before the farm can be sampled
+    ImGui::BeginDisabled(busy || loading);
+    if (ImGui::Button("Run")) {
+        this->start(farm, registry);
+    }
+    ImGui::EndDisabled();
+
+    if (busy) {
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            this->cancelled = true;
+        }
+        ImGui::SameLine();
+        ImGui::ProgressBar((float) this->progress / this->workItems);
+    } else if (loading) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Waiting for plot details");
+    }
+
+    if (this->hasResult && !busy) {
+        Result& result = this->result;
+        ImGui::SeparatorText("Total Harvest");
+        ImGui::Text("Mean: %.1f lbs", result.mean);
+        ImGui::Text("Deviation: %.1f lbs", result.deviation);
+        ImGui::Text("5th / 50th / 95th: %.1f / %.1f / %.1f lbs", result.p5, result.p50, result.p95);
+        ImGui::Text("Range: %.1f to %.1f lbs", result.lowest, result.highest);
+        ImGui::PlotHistogram("##harvests", result.histogram, SIMULATION_BINS, 0, nullptr, 0.0f, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 80));
+
+        double samples = (double) result.trials * result.plots;
+        ImGui::TextDisabled("%d trials of %d plots in %.2f s, %.1fM samples/s", result.trials, result.plots, result.seconds,
+            samples / std::max(result.seconds, 1e-6f) / 1e6);
+    }
+
+    ImGui::End();
+}
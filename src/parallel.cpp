@@ -0,0 +1,50 @@
+/*
+ *  parallel.cpp - helpers for splitting work across threads
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// hardware_concurrency is allowed to return 0 when it doesnt know
+int Parallel::workerCount() {
+    int count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+void Parallel::forRange(int count, int blockSize, std::function<void(int, int)> fn) {
+    if (count <= 0) {
+        return;
+    }
+
+    // no point starting threads that would have nothing to do
+    int blocks = (count + blockSize - 1) / blockSize;
+    int threads = std::min(Parallel::workerCount(), blocks);
+
+    if (threads <= 1) {
+        fn(0, count);
+        return;
+    }
+
+    // every thread grabs the next unclaimed block, so uneven blocks still balance out
+    std::atomic<int> next(0);
+    auto work = [&]() {
+        int block;
+        while ((block = next++) < blocks) {
+            int begin = block * blockSize;
+            int end = std::min(begin + blockSize, count);
+            fn(begin, end);
+        }
+    };
+
+    // the calling thread does its share of the work too
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++) {
+        workers.emplace_back(work);
+    }
+
+    work();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
@@ -0,0 +1,264 @@
+/*
+ *  plants.cpp - every plant of every plot, a byte each
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// every byte with its top bit moved to the bottom, so one multiply adds up 8 plants
+#define PLANT_LOW_BITS 0x0101010101010101ull
+
+// integer hash, every plant rolls its own number so sowing a plot again gives the same plants
+static inline uint32_t mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+// sows one row, plain enough that the compiler does it several plants at a time
+// the roll is keyed on the row and column, so growing a plot keeps the plants it already had
+static void sowRow(uint8_t* row, int count, uint32_t key, uint32_t threshold) {
+    for (int column = 0; column < count; column++) {
+        uint32_t roll = mix(key + (uint32_t) column * 0x9e3779b9u) >> 8;
+        row[column] = GROWTH_STAGE_SEEDLING | (roll < threshold ? PLANT_ALIVE : 0);
+    }
+}
+
+// live plants of a run, 8 at a time
+static int countAlive(const uint8_t* states, int count) {
+    int alive = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint64_t word;
+        memcpy(&word, states + i, sizeof(word));
+        alive += (((word >> 7) & PLANT_LOW_BITS) * PLANT_LOW_BITS) >> 56;
+    }
+    for (; i < count; i++) {
+        alive += states[i] >> 7;
+    }
+    return alive;
+}
+
+PlantStore::PlantStore() {
+    this->open = false;
+    this->emergence = PLANT_DEFAULT_EMERGENCE;
+    this->seed = 1;
+    this->plantTotal = 0;
+    this->aliveTotal = 0;
+    this->harvest = 0.0;
+    this->farm = nullptr;
+    this->farmVersion = 0;
+    this->registryVersion = -1;
+    this->sownEmergence = -1;
+    this->sownSeed = 0;
+}
+
+void PlantStore::reset() {
+    this->farm = nullptr;
+}
+
+const uint8_t* PlantStore::plantsOf(int plot) {
+    return this->states.data() + this->starts[plot];
+}
+
+int64_t PlantStore::plants() {
+    return this->plantTotal;
+}
+
+int64_t PlantStore::living() {
+    return this->aliveTotal;
+}
+
+double PlantStore::liveHarvest() {
+    return this->harvest;
+}
+
+size_t PlantStore::bytes() {
+    return this->states.size();
+}
+
+void PlantStore::place(int plot, int count) {
+    if (count <= this->capacities[plot]) {
+        return;
+    }
+
+    this->starts[plot] = this->states.size();
+    this->capacities[plot] = count;
+    this->states.resize(this->states.size() + count);
+}
+
+void PlantStore::sow(int plot, Plot* source) {
+    int columns = source->plantColumns();
+    int rows = source->plantRows();
+    uint8_t* run = this->states.data() + this->starts[plot];
+
+    // a share of 2^24, so 100% lets every roll through
+    uint32_t threshold = (uint32_t) (((uint64_t) this->emergence << 24) / 100);
+    uint32_t plotKey = mix((uint32_t) this->seed * 0x85ebca6bu ^ mix(plot));
+    for (int row = 0; row < rows; row++) {
+        sowRow(run + (int64_t) row * columns, columns, mix(plotKey + (uint32_t) row * 0xc2b2ae35u), threshold);
+    }
+
+    this->columns[plot] = columns;
+    this->counts[plot] = columns * rows;
+    this->alive[plot] = countAlive(run, columns * rows);
+    this->yields[plot] = source->expectedYield;
+}
+
+void PlantStore::compact() {
+    std::vector<uint8_t> packed(this->plantTotal);
+    int64_t offset = 0;
+    for (int plot = 0; plot < (int) this->starts.size(); plot++) {
+        memcpy(packed.data() + offset, this->states.data() + this->starts[plot], this->counts[plot]);
+        this->starts[plot] = offset;
+        this->capacities[plot] = this->counts[plot];
+        offset += this->counts[plot];
+    }
+
+    this->states.swap(packed);
+}
+
+void PlantStore::refresh(Farm* farm, CropRegistry* registry) {
+    // a different farm, reloaded crops or other settings sow everything again, so do plots going away
+    bool full = farm != this->farm || registry->version != this->registryVersion || this->emergence != this->sownEmergence ||
+        this->seed != this->sownSeed || farm->plots.size() < this->counts.size();
+
+    if (full) {
+        int count = farm->plots.size();
+        this->starts.resize(count);
+        this->capacities.resize(count);
+        this->columns.resize(count);
+        this->counts.resize(count);
+        this->alive.resize(count);
+        this->yields.resize(count);
+
+        // runs are laid out first, then every block of plots sows its own part of the buffer
+        int64_t offset = 0;
+        for (auto& plot : farm->plots) {
+            plot->syncCrop();
+            this->starts[plot->id] = offset;
+            this->capacities[plot->id] = (int) plot->plantCount();
+            offset += this->capacities[plot->id];
+        }
+        this->states.assign(offset, 0);
+        this->states.shrink_to_fit();
+
+        Parallel::forRange(count, PARALLEL_BLOCK, [&](int begin, int end) {
+            for (int id = begin; id < end; id++) {
+                this->sow(id, farm->plots[id]);
+            }
+        });
+
+        this->plantTotal = 0;
+        this->aliveTotal = 0;
+        this->harvest = 0.0;
+        for (int id = 0; id < count; id++) {
+            this->plantTotal += this->counts[id];
+            this->aliveTotal += this->alive[id];
+            this->harvest += this->alive[id] * (double) this->yields[id];
+        }
+
+        this->farm = farm;
+        this->farmVersion = farm->version;
+        this->registryVersion = registry->version;
+        this->sownEmergence = this->emergence;
+        this->sownSeed = this->seed;
+        return;
+    }
+
+    if (farm->version == this->farmVersion) {
+        return;
+    }
+
+    // new plots start out with no plants, so adding them is the same as changing them
+    this->changed.clear();
+    for (int id = this->counts.size(); id < (int) farm->plots.size(); id++) {
+        this->starts.push_back(this->states.size());
+        this->capacities.push_back(0);
+        this->columns.push_back(0);
+        this->counts.push_back(0);
+        this->alive.push_back(0);
+        this->yields.push_back(0.0f);
+        this->changed.push_back(id);
+    }
+
+    farm->changedSince(this->farmVersion, &this->changed);
+
+    // a plot is in the log once for every edit, sowing it again gives the same plants so repeats only cost time
+    for (int id : this->changed) {
+        Plot* plot = farm->plots[id];
+        this->plantTotal -= this->counts[id];
+        this->aliveTotal -= this->alive[id];
+        this->harvest -= this->alive[id] * (double) this->yields[id];
+
+        plot->syncCrop();
+        this->place(id, (int) plot->plantCount());
+        this->sow(id, plot);
+
+        this->plantTotal += this->counts[id];
+        this->aliveTotal += this->alive[id];
+        this->harvest += this->alive[id] * (double) this->yields[id];
+    }
+
+    // runs left behind by plots that grew and space freed by ones that shrank get packed once they are half the buffer
+    if ((int64_t) this->states.size() > this->plantTotal * 2) {
+        this->compact();
+    }
+
+    this->farmVersion = farm->version;
+}
+
+void PlantStore::render(SDL_Renderer* renderer, Farm* farm, CropRegistry* registry) {
+    this->refresh(farm, registry);
+
+    // one dot in the middle of every lattice square, only for the plots on screen
+    SDL_Rect canvas = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    this->aliveDots.clear();
+    this->deadDots.clear();
+    for (auto& plot : farm->plots) {
+        if (!SDL_HasIntersection(&plot->bounds, &canvas) || this->counts[plot->id] == 0) {
+            continue;
+        }
+
+        int spacing = plot->crop->spacing;
+        int columns = this->columns[plot->id];
+        int count = this->counts[plot->id];
+        const uint8_t* run = this->plantsOf(plot->id);
+        int left = plot->bounds.x + PLOT_PADDING + spacing / 2;
+        int top = plot->bounds.y + PLOT_PADDING + spacing / 2;
+        for (int i = 0; i < count; i++) {
+            SDL_Point dot = {left + (i % columns) * spacing, top + (i / columns) * spacing};
+            (run[i] & PLANT_ALIVE ? this->aliveDots : this->deadDots).push_back(dot);
+        }
+    }
+
+    SDL_SetRenderDrawColor(renderer, 20, 90, 20, 255);
+    SDL_RenderDrawPoints(renderer, this->aliveDots.data(), this->aliveDots.size());
+    SDL_SetRenderDrawColor(renderer, 150, 60, 30, 255);
+    SDL_RenderDrawPoints(renderer, this->deadDots.data(), this->deadDots.size());
+}
+
+void PlantStore::show(Farm* farm, CropRegistry* registry) {
+    ImGui::Checkbox("Show Plants", &this->open);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+    ImGui::SliderInt("Emergence", &this->emergence, 0, 100, "%d%%");
+
+    if (!this->open) {
+        return;
+    }
+
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6);
+    ImGui::InputInt("Seed", &this->seed);
+
+    this->refresh(farm, registry);
+
+    double stand = this->plantTotal > 0 ? this->aliveTotal * 100.0 / this->plantTotal : 0.0;
+    ImGui::Text("Plants Up: %lld of %lld (%.1f%%)", (long long) this->aliveTotal, (long long) this->plantTotal, stand);
+    ImGui::Text("Harvest From Live Plants: %.2f lbs", this->harvest);
+    ImGui::TextDisabled("%.1f MB, %.2f bytes per plant", this->states.size() / (1024.0 * 1024.0),
+        this->plantTotal > 0 ? (double) this->states.size() / this->plantTotal : 0.0);
+}
@@ -12,13 +12,18 @@
 // plot constructor, takes in crop, size, and design information
 Plot::Plot(int x, int y, int width, int height, std::string name, int cropIndex, double cropDeviation, CropRegistry::CropEntry* crop) {
     this->bounds = (SDL_Rect){x, y, width, height};
-    this->windowOpen = false;
+    this->id = -1;
+    this->dirty = false;
+    this->revision = 0;
+    this->details = PLOT_DETAILS_READY;
 
     // copy name over into char buffer for imgui input
     memset(this->plotName, 0, sizeof(this->plotName));
     strcpy(this->plotName, name.c_str());
 
     // get crop information from registry field
+    this->crop = crop;
+    this->cropVersion = crop->version;
     this->cropName = crop->name;
     this->cropIndex = cropIndex;
     this->expectedYield = crop->avgYield;
@@ -26,7 +31,10 @@ Plot::Plot(int x, int y, int width, int height, std::string name, int cropIndex,
     this->color = crop->color;
 }
 
-void Plot::render(SDL_Renderer* renderer) {
+void Plot::render(SDL_Renderer* renderer, SDL_Texture* hatch) {
+    // pick up crop reloads here, every plot gets drawn anyway so this costs nothing extra
+    this->syncCrop();
+
     // draw the outline of the plot different colors based on selection/hovering
     if (this->isSelected()) {
         // almost white
@@ -42,38 +50,18 @@ void Plot::render(SDL_Renderer* renderer) {
     // draw the bounding box
     SDL_RenderDrawRect(renderer, &this->bounds);
 
-    // set rendering color to color of plot
-    SDL_SetRenderDrawColor(renderer, this->color.r, this->color.g, this->color.b, this->color.a);
     // calculate rendering offsets
     int offx = this->bounds.x + PLOT_PADDING;
     int offy = this->bounds.y + PLOT_PADDING;
     int effectiveWidth = this->bounds.w - (PLOT_PADDING * 2);
     int effectiveHeight = this->bounds.h - (PLOT_PADDING * 2);
-    int largestBound = effectiveWidth > effectiveHeight ? effectiveWidth : effectiveHeight;
-    int partitions = largestBound / PLOT_LINE_SPACING;
-    
-    // create render texture for rendering
-    SDL_Texture* renderTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
-        effectiveWidth * 2, effectiveHeight * 2);
-    // target the created texture
-    SDL_SetRenderTarget(renderer, renderTexture);
-
-    // split width into segments and draw lines diagonally
-    for (int i = 0; i <= partitions * 2; i++) {
-        SDL_Point start = {0, i * PLOT_LINE_SPACING};
-        SDL_Point end = {i * (PLOT_LINE_SPACING), 0};
-    
-        SDL_RenderDrawLine(renderer, start.x, start.y, end.x, end.y);
-    }
-
-    // set render target back to main window
-    SDL_SetRenderTarget(renderer, NULL);
 
-    // render our plot onto the screen
+    // the hatching is the same for every plot, only the color changes
+    // so it is tinted and copied instead of drawn into a new texture every frame
+    SDL_SetTextureColorMod(hatch, this->color.r, this->color.g, this->color.b);
     SDL_Rect src = {0, 0, effectiveWidth, effectiveHeight};
     SDL_Rect dst = {offx, offy, effectiveWidth, effectiveHeight};
-    SDL_RenderCopy(renderer, renderTexture, &src, &dst);
-    SDL_DestroyTexture(renderTexture);
+    SDL_RenderCopy(renderer, hatch, &src, &dst);
 
     SDL_SetRenderDrawColor(renderer, 0xD0, 0x10, 0x10, 0xff);
     SDL_RenderDrawRect(renderer, &this->tmp);
@@ -94,9 +82,6 @@ void Plot::updateNonSelected(bool forceNoUpdate) {
 // returns true/false based on if a right click was in the plots bounds
 bool Plot::registerClick(const SDL_Point* p) {
     if (SDL_PointInRect(p, &this->bounds)) {
-        // toggle window being open
-        this->windowOpen = !this->windowOpen;
-        this->windowPos = *p;
         return true;
     }
 
@@ -204,14 +189,75 @@ void Plot::updateFromInputs(int xin, int yin, int win, int hin, std::vector<Plot
 
 // resets all the plot's properties based on a new crop selection
 void Plot::updateProperties(CropRegistry::CropEntry* entry, int index) {
+    this->crop = entry;
+    this->cropVersion = entry->version;
     this->cropName = entry->name;
     this->cropIndex = index;
     this->expectedYield = entry->avgYield;
     this->color = entry->color;
 }
 
+// only plots whose crop was actually changed by a reload do anything here
+bool Plot::syncCrop() {
+    if (this->cropVersion == this->crop->version) {
+        return false;
+    }
+
+    this->cropVersion = this->crop->version;
+    this->expectedYield = this->crop->avgYield;
+    this->color = this->crop->color;
+    return true;
+}
+
 // moves the plot
 void Plot::move(int deltaX, int deltaY) {
     this->bounds.x += deltaX;
     this->bounds.y += deltaY;
-}
\ No newline at end of file
+}
+
+// copies the saved fields into a plain record
+void Plot::toRecord(PlotRecord* record) {
+    record->id = this->id;
+    record->bounds = this->bounds;
+    memcpy(record->name, this->plotName, sizeof(record->name));
+    record->crop = this->cropName;
+    record->cropIndex = this->crop->index;
+    record->deviation = this->yieldDeviance;
+}
+
+// plots loaded from an index get their name and deviation filled in on another thread
+bool Plot::hasDetails() {
+    return this->details.load(std::memory_order_acquire) == PLOT_DETAILS_READY;
+}
+
+// the lattice of a plot this size, cut off at PLOT_MAX_PLANTS by dropping rows
+static void latticeOf(SDL_Rect bounds, int spacing, int* columns, int* rows) {
+    *columns = std::min(std::max(bounds.w - PLOT_PADDING * 2, 0) / spacing, PLOT_MAX_PLANTS);
+    *rows = std::min(std::max(bounds.h - PLOT_PADDING * 2, 0) / spacing, PLOT_MAX_PLANTS / std::max(*columns, 1));
+}
+
+int Plot::plantColumns() {
+    int columns, rows;
+    latticeOf(this->bounds, this->crop->spacing, &columns, &rows);
+    return columns;
+}
+
+int Plot::plantRows() {
+    int columns, rows;
+    latticeOf(this->bounds, this->crop->spacing, &columns, &rows);
+    return rows;
+}
+
+int64_t Plot::plantCount() {
+    return Plot::plantsFor(this->bounds, this->crop->spacing);
+}
+
+int64_t Plot::plantsFor(SDL_Rect bounds, int spacing) {
+    int columns, rows;
+    latticeOf(bounds, spacing, &columns, &rows);
+    return (int64_t) columns * rows;
+}
+
+double Plot::expectedHarvest() {
+    return this->plantCount() * (double) this->expectedYield;
+}
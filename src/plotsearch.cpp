@@ -0,0 +1,237 @@
+/*
+ *  plotsearch.cpp - finding plots by name or crop
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// lowercases a plot's name into out, which has to be as big as the name field
+// plots still waiting on their details have an empty name, the same as the plot table
+static std::string_view lowerName(Plot* plot, char* out) {
+    int length = 0;
+    if (plot->hasDetails()) {
+        while (plot->plotName[length] && length < (int) sizeof(plot->plotName) - 1) {
+            out[length] = tolower((unsigned char) plot->plotName[length]);
+            length++;
+        }
+    }
+    return std::string_view(out, length);
+}
+
+PlotSearch::PlotSearch() {
+    this->farm = nullptr;
+    this->farmVersion = 0;
+    this->registryVersion = -1;
+    this->detailsDone = false;
+    this->resultsDirty = true;
+    memset(this->buffer, 0, sizeof(this->buffer));
+}
+
+void PlotSearch::reset() {
+    this->farm = nullptr;
+}
+
+std::vector<int>& PlotSearch::matches() {
+    return this->results;
+}
+
+void PlotSearch::rebuild(Farm* farm) {
+    int count = farm->plots.size();
+
+    std::vector<std::string> names(count);
+    this->crops.resize(count);
+    for (auto& plot : farm->plots) {
+        char name[sizeof(plot->plotName)];
+        names[plot->id] = lowerName(plot, name);
+        this->crops[plot->id] = plot->crop->index;
+    }
+    this->index.build(names);
+
+    // old results point at the last farm's ids
+    this->results.clear();
+    this->stale.clear();
+    this->staleNames.clear();
+    this->staleMark.assign(count, 0);
+    this->resultsDirty = true;
+}
+
+void PlotSearch::refreshPlot(Plot* plot) {
+    int id = plot->id;
+
+    if (this->crops[id] != plot->crop->index) {
+        this->crops[id] = plot->crop->index;
+        this->resultsDirty = true;
+    }
+
+    char buffer[sizeof(plot->plotName)];
+    std::string_view name = lowerName(plot, buffer);
+
+    // a renamed plot is checked by hand until the next rebuild, the index still has its old name
+    if (this->staleMark[id]) {
+        int at = std::lower_bound(this->stale.begin(), this->stale.end(), id) - this->stale.begin();
+        if (this->staleNames[at] != name) {
+            this->staleNames[at] = name;
+            this->resultsDirty = true;
+        }
+    } else if (id >= this->index.size() || this->index.name(id) != name) {
+        int at = std::lower_bound(this->stale.begin(), this->stale.end(), id) - this->stale.begin();
+        this->stale.insert(this->stale.begin() + at, id);
+        this->staleNames.insert(this->staleNames.begin() + at, std::string(name));
+        this->staleMark[id] = 1;
+        this->resultsDirty = true;
+    }
+}
+
+void PlotSearch::refresh(Farm* farm, CropRegistry* registry) {
+    bool detailsDone = farm->detailLoader == nullptr || farm->detailLoader->done();
+
+    // every name changes when a different farm is shown or the details finish loading
+    if (farm != this->farm || detailsDone != this->detailsDone) {
+        this->rebuild(farm);
+        this->farm = farm;
+        this->farmVersion = farm->version;
+        this->registryVersion = registry->version;
+        this->detailsDone = detailsDone;
+        return;
+    }
+
+    // a reload can reorder the crops, only their column has to be copied again
+    if (registry->version != this->registryVersion) {
+        for (auto& plot : farm->plots) {
+            this->crops[plot->id] = plot->crop->index;
+        }
+        this->registryVersion = registry->version;
+        this->resultsDirty = true;
+    }
+
+    if (farm->version == this->farmVersion) {
+        return;
+    }
+
+    // plots added since the last refresh arent in the index yet
+    for (int id = this->crops.size(); id < (int) farm->plots.size(); id++) {
+        this->crops.push_back(-1);
+        this->staleMark.push_back(0);
+        this->refreshPlot(farm->plots[id]);
+    }
+
+    this->changed.clear();
+    farm->changedSince(this->farmVersion, &this->changed);
+    for (int id : this->changed) {
+        this->refreshPlot(farm->plots[id]);
+    }
+    this->farmVersion = farm->version;
+
+    // checking renamed plots by hand only pays off while there are few of them
+    if (this->stale.size() > PLOT_SEARCH_STALE_LIMIT) {
+        this->rebuild(farm);
+    }
+}
+
+void PlotSearch::search(CropRegistry* registry) {
+    // called every frame, an unchanged query is checked without copying it
+    size_t length = strlen(this->buffer);
+    if (!this->resultsDirty && length == this->text.size()) {
+        size_t i = 0;
+        while (i < length && tolower((unsigned char) this->buffer[i]) == this->text[i]) {
+            i++;
+        }
+        if (i == length) {
+            return;
+        }
+    }
+
+    this->text = this->buffer;
+    for (char& c : this->text) {
+        c = tolower((unsigned char) c);
+    }
+
+    this->results.clear();
+    this->resultsDirty = false;
+
+    if (this->text.empty()) {
+        return;
+    }
+
+    // names the index still has right, renamed plots are left to the next step
+    this->index.update(&this->nameQuery, this->buffer);
+    this->named.clear();
+    for (int id : this->nameQuery.results) {
+        if (!this->staleMark[id]) {
+            this->named.push_back(id);
+        }
+    }
+
+    // both lists are sorted, so they only need merging
+    size_t indexed = this->named.size();
+    for (int i = 0; i < (int) this->stale.size(); i++) {
+        if (SearchIndex::matches(this->staleNames[i], this->text)) {
+            this->named.push_back(this->stale[i]);
+        }
+    }
+    std::inplace_merge(this->named.begin(), this->named.begin() + indexed, this->named.end());
+
+    // plots growing a crop whose name matches, there are few crops so only the plot column is long
+    this->cropPlots.clear();
+    registry->search.find(this->text, &this->cropHits);
+    if (!this->cropHits.empty()) {
+        this->cropMark.assign(registry->ordered.size(), 0);
+        for (int crop : this->cropHits) {
+            this->cropMark[crop] = 1;
+        }
+
+        for (int id = 0; id < (int) this->crops.size(); id++) {
+            if (this->cropMark[this->crops[id]]) {
+                this->cropPlots.push_back(id);
+            }
+        }
+    }
+
+    std::set_union(this->named.begin(), this->named.end(), this->cropPlots.begin(), this->cropPlots.end(), std::back_inserter(this->results));
+}
+
+void PlotSearch::show(Farm* farm, CropRegistry* registry, PlotWindows* windows) {
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    bool enter = ImGui::InputTextWithHint("##plotsearch", "Plot or crop name", this->buffer, sizeof(this->buffer), ImGuiInputTextFlags_EnterReturnsTrue);
+
+    // nothing is indexed until something is searched for
+    if (this->buffer[0] != '\0') {
+        this->refresh(farm, registry);
+    }
+    this->search(registry);
+
+    if (this->buffer[0] == '\0') {
+        return;
+    }
+
+    // enter jumps to the first match
+    if (enter && !this->results.empty()) {
+        windows->open(farm->plots[this->results.front()]);
+    }
+
+    ImGui::Text("Matches: %d", (int) this->results.size());
+    if (this->results.empty()) {
+        return;
+    }
+
+    float height = std::min((int) this->results.size(), PLOT_SEARCH_ROWS) * ImGui::GetTextLineHeightWithSpacing();
+    ImGui::BeginChild("plot_search_results", ImVec2(0, height));
+    {
+        ImGuiListClipper clipper;
+        clipper.Begin(this->results.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                Plot* plot = farm->plots[this->results[i]];
+
+                ImGui::PushID(plot->id);
+                if (ImGui::Selectable(plot->hasDetails() ? plot->plotName : "Loading...", windows->isOpen(plot))) {
+                    windows->open(plot);
+                }
+                ImGui::SameLine();
+                ImGui::TextDisabled("%s", plot->crop->name.c_str());
+                ImGui::PopID();
+            }
+        }
+    }
+    ImGui::EndChild();
+}
@@ -0,0 +1,53 @@
+/*
+ *  plotwindows.cpp - which plots have their config window open
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+void PlotWindows::open(Plot* plot) {
+    // opening a window closes every other one, unless it was pinned
+    int kept = 0;
+    bool found = false;
+    for (auto& window : this->windows) {
+        if (window.plot == plot || window.pinned) {
+            found |= window.plot == plot;
+            this->windows[kept++] = window;
+        }
+    }
+    this->windows.resize(kept);
+
+    if (!found) {
+        this->windows.push_back(Window{plot, false});
+    }
+}
+
+void PlotWindows::close(Plot* plot) {
+    for (auto window = this->windows.begin(); window != this->windows.end(); window++) {
+        if (window->plot == plot) {
+            this->windows.erase(window);
+            return;
+        }
+    }
+}
+
+void PlotWindows::toggle(Plot* plot) {
+    if (this->isOpen(plot)) {
+        this->close(plot);
+    } else {
+        this->open(plot);
+    }
+}
+
+bool PlotWindows::isOpen(Plot* plot) {
+    for (auto& window : this->windows) {
+        if (window.plot == plot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PlotWindows::clear() {
+    this->windows.clear();
+}
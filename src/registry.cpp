@@ -8,13 +8,20 @@
 // constructor for creating hashmap
 CropRegistry::CropRegistry() {
     this->registry = std::unordered_map<std::string, CropEntry*>();
+    this->version = 0;
 }
 
 // constructor for CropEntry subclass
 CropRegistry::CropEntry::CropEntry(std::string name, double avgYield, int red, int green, int blue) {
-    this->name = name;
+    this->name = std::move(name);
     this->avgYield = avgYield;
     this->color = (SDL_Color){(char) red, (char) green, (char) blue, 0xFF};
+    this->growthDays = CROP_DEFAULT_GROWTH_DAYS;
+    this->plantingDay = CROP_DEFAULT_PLANTING_DAY;
+    this->spacing = CROP_DEFAULT_SPACING;
+    this->family = this->name;
+    this->version = 0;
+    this->index = 0;
 }
 
 // deletes the allocated crop entries
@@ -26,37 +33,76 @@ CropRegistry::~CropRegistry() {
 
 // adds new entry to the hashmap if it isnt already added
 void CropRegistry::addEntry(std::string name, double yield, int red, int green, int blue) {
-    if (this->registry.find(name) == this->registry.end()) {
-        this->registry[name] = new CropRegistry::CropEntry(name, yield, red, green, blue);
+    // one lookup, the slot is only filled in if the name was new
+    auto result = this->registry.try_emplace(name, nullptr);
+    if (result.second) {
+        result.first->second = new CropRegistry::CropEntry(name, yield, red, green, blue);
+    }
+}
+
+void CropRegistry::reserve(size_t count) {
+    // unordered_map::reserve can also shrink the table, which would undo an earlier bigger reserve
+    size_t wanted = this->registry.size() + count;
+    if (wanted > this->registry.bucket_count() * this->registry.max_load_factor()) {
+        this->registry.reserve(wanted);
+    }
+}
+
+// bulk version of addEntry, the table only grows once
+void CropRegistry::addEntries(std::vector<CropEntry*>& entries) {
+    this->reserve(entries.size());
+
+    for (auto& entry : entries) {
+        auto result = this->registry.try_emplace(entry->name, entry);
+        if (!result.second) {
+            delete entry;
+        }
     }
 }
 
 void CropRegistry::loadFromCSV(std::string filename) {
     // read from default csv file, by default should be "crop.csv"
-    // format: crop-name, crop yield, r, g, b
-    io::CSVReader<5> csvReader(filename);
-    csvReader.read_header(io::ignore_missing_column, "name", "yield", "red", "green", "blue");
+    // format: crop-name, crop yield, r, g, b, days to harvest, first planting day, plant family, plant spacing
+    // the last four are optional, older tables without them get the defaults
+    io::CSVReader<9> csvReader(filename);
+    csvReader.read_header(io::ignore_missing_column, "name", "yield", "red", "green", "blue", "days", "start", "family", "spacing");
 
     // fields to read into, passed by reference
+    // missing columns leave their field alone
     std::string name;
     double yield;
     int red, green, blue;
-
-    // read in all the data and add entries to table
-    while (csvReader.read_row(name, yield, red, green, blue)) {
-        this->addEntry(name, yield, red, green, blue);
+    int days = CROP_DEFAULT_GROWTH_DAYS;
+    int start = CROP_DEFAULT_PLANTING_DAY;
+    std::string family;
+    int spacing = CROP_DEFAULT_SPACING;
+
+    // read in all the data, then add it to the table in one go
+    std::vector<CropEntry*> entries;
+    while (csvReader.read_row(name, yield, red, green, blue, days, start, family, spacing)) {
+        CropEntry* entry = new CropRegistry::CropEntry(name, yield, red, green, blue);
+        entry->growthDays = std::max(1, days);
+        entry->plantingDay = std::max(0, start);
+        entry->spacing = std::max(CROP_MIN_SPACING, spacing);
+        if (!family.empty()) {
+            entry->family = family;
+        }
+        entries.push_back(entry);
     }
 
-    // adds a type for null selections at the end, so it has an index of 0
+    this->addEntries(entries);
+
+    // adds a type for null selections, the ordered list puts it at index 0
     this->addEntry("NO SELECTION", 0.0, 120, 120, 120);
+    this->buildIndex();
 }
 
-// returns the list of crops stored in the table
+// returns the list of crops stored in the table, in the same order as the crop indexes
 std::vector<std::string> CropRegistry::getKeyList() {
     std::vector<std::string> list;
     
-    for (const auto& pair : this->registry) {
-        list.push_back(pair.first);
+    for (auto& entry : this->ordered) {
+        list.push_back(entry->name);
     }
     
     return list;
@@ -98,11 +144,102 @@ void CropRegistry::freeCSTRS(char** list, int size) {
 
 // get crop data based on the crop's name
 CropRegistry::CropEntry* CropRegistry::access(std::string name) {
+    // a single lookup, this also keeps it safe to call from several threads at once
+    auto found = this->registry.find(name);
+
     // if the crop isnt found, return nullptr
-    if (this->registry.find(name) == this->registry.end()) {
+    if (found == this->registry.end()) {
         return nullptr;
     // return the crop data if found
     } else {
-        return this->registry[name];
+        return found->second;
+    }
+}
+
+CropReload::CropReload() {
+    this->reordered = false;
+}
+
+// updates crops in place and adds new ones
+// crops that disappeared from the file are kept, plots might still be using them
+void CropRegistry::applyChanges(CropReload& reload, Farm* farm) {
+    this->version++;
+    for (auto& change : reload.changes) {
+        auto found = this->registry.find(change.name);
+
+        if (found == this->registry.end()) {
+            this->addEntry(change.name, change.avgYield, change.color.r, change.color.g, change.color.b);
+            CropEntry* entry = this->access(change.name);
+            entry->growthDays = change.growthDays;
+            entry->plantingDay = change.plantingDay;
+            entry->family = change.family;
+            entry->spacing = change.spacing;
+        } else {
+            CropEntry* entry = found->second;
+            entry->avgYield = change.avgYield;
+            entry->color = change.color;
+            entry->growthDays = change.growthDays;
+            entry->plantingDay = change.plantingDay;
+            entry->family = change.family;
+            entry->spacing = change.spacing;
+            entry->version++;
+        }
     }
-}
\ No newline at end of file
+
+    // new crops shift the order, the watcher already sorted it and built the search index on its thread
+    if (reload.reordered) {
+        this->ordered.clear();
+        this->ordered.reserve(reload.order.size());
+        for (auto& name : reload.order) {
+            CropEntry* entry = this->access(name);
+            if (entry) {
+                entry->index = this->ordered.size();
+                this->ordered.push_back(entry);
+            }
+        }
+
+        this->search.adopt(reload.search);
+    }
+
+    // every plot of the farm being edited is brought up to date here, so nothing that reads them has to remember to
+    if (farm) {
+        Parallel::forRange(farm->plots.size(), PARALLEL_BLOCK, [&](int begin, int end) {
+            for (int id = begin; id < end; id++) {
+                Plot* plot = farm->plots[id];
+                plot->syncCrop();
+                plot->cropIndex = plot->crop->index;
+            }
+        });
+    }
+}
+
+// sorts the crops by name and indexes the names for the crop picker
+void CropRegistry::buildIndex() {
+    CropEntry* none = this->access("NO SELECTION");
+
+    this->ordered.clear();
+    this->ordered.reserve(this->registry.size());
+    for (const auto& pair : this->registry) {
+        if (pair.second != none) {
+            this->ordered.push_back(pair.second);
+        }
+    }
+
+    std::sort(this->ordered.begin(), this->ordered.end(), [](CropEntry* a, CropEntry* b) {
+        return a->name < b->name;
+    });
+
+    // the null selection always comes first so it has an index of 0
+    if (none) {
+        this->ordered.insert(this->ordered.begin(), none);
+    }
+
+    std::vector<std::string> names;
+    names.reserve(this->ordered.size());
+    for (int i = 0; i < (int) this->ordered.size(); i++) {
+        this->ordered[i]->index = i;
+        names.push_back(this->ordered[i]->name);
+    }
+
+    this->search.build(names);
+}
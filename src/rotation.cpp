@@ -0,0 +1,518 @@
+/*
+ *  rotation.cpp - planning crops for every plot over several seasons
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// starting and final temperature of a chain as a share of an average plot's harvest
+#define ROTATION_HOT 0.5
+#define ROTATION_COLD 0.0005
+
+RotationPlanner::RotationPlanner() {
+    this->open = false;
+    this->seasons = 4;
+    this->gap = 1;
+    this->neighborPenalty = 10.0f;
+    this->sweeps = 200;
+    this->seed = 1;
+    this->allQuotas = 100;
+    this->applySeason = 0;
+    this->cropCount = 0;
+    this->planFarm = nullptr;
+    this->planRegistryVersion = -1;
+    this->finished = false;
+    this->plan = {};
+    this->hasResult = false;
+}
+
+RotationPlanner::~RotationPlanner() {
+    this->annealing.cancelled = true;
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+}
+
+void RotationPlanner::reset() {
+    if (this->worker.joinable()) {
+        this->annealing.cancelled = true;
+        this->worker.join();
+    }
+
+    this->hasResult = false;
+    this->planFarm = nullptr;
+}
+
+void RotationPlanner::findNeighbors(Farm* farm) {
+    int count = farm->plots.size();
+    this->neighborStart.assign(count + 1, 0);
+    this->neighbors.clear();
+    if (count == 0) {
+        return;
+    }
+
+    // each plot goes in every cell its reach touches
+    PlotGrid grid;
+    grid.build(farm->plots, ROTATION_NEIGHBOR_DISTANCE);
+    auto reach = [&](Plot* plot) {
+        SDL_Rect bounds = plot->bounds;
+        return SDL_Rect{bounds.x - ROTATION_NEIGHBOR_DISTANCE, bounds.y - ROTATION_NEIGHBOR_DISTANCE,
+            bounds.w + ROTATION_NEIGHBOR_DISTANCE * 2, bounds.h + ROTATION_NEIGHBOR_DISTANCE * 2};
+    };
+
+    // two plots are neighbors if either one's reach overlaps the other, which is the same both ways
+    std::vector<std::vector<int>> lists(count);
+    Parallel::forRange(count, 1024, [&](int begin, int end) {
+        for (int id = begin; id < end; id++) {
+            SDL_Rect around = reach(farm->plots[id]);
+            std::vector<int>& list = lists[id];
+
+            grid.forCells(around, [&](int at) {
+                for (int i = grid.starts[at]; i < grid.starts[at + 1]; i++) {
+                    int other = grid.ids[i];
+                    if (other != id && SDL_HasIntersection(&around, &farm->plots[other]->bounds)) {
+                        list.push_back(other);
+                    }
+                }
+            });
+
+            std::sort(list.begin(), list.end());
+            list.erase(std::unique(list.begin(), list.end()), list.end());
+        }
+    });
+
+    for (int id = 0; id < count; id++) {
+        this->neighborStart[id + 1] = this->neighborStart[id] + lists[id].size();
+    }
+    this->neighbors.reserve(this->neighborStart.back());
+    for (auto& list : lists) {
+        this->neighbors.insert(this->neighbors.end(), list.begin(), list.end());
+    }
+}
+
+void RotationPlanner::snapshot(Farm* farm, CropRegistry* registry) {
+    int count = farm->plots.size();
+    this->cropCount = registry->ordered.size();
+    this->quotas.resize(this->cropCount, 100);
+
+    // families are numbered in the order they turn up, the empty crop has none
+    std::unordered_map<std::string, int> familyIds;
+    this->yields.resize(this->cropCount);
+    this->spacings.resize(this->cropCount);
+    this->families.resize(this->cropCount);
+    this->limits.resize(this->cropCount);
+    this->candidates.assign(1, 0);
+    for (int crop = 0; crop < this->cropCount; crop++) {
+        CropRegistry::CropEntry* entry = registry->ordered[crop];
+        this->yields[crop] = crop == 0 ? 0.0f : entry->avgYield;
+        this->spacings[crop] = entry->spacing;
+        this->families[crop] = crop == 0 ? -1 : familyIds.try_emplace(entry->family, familyIds.size()).first->second;
+        this->limits[crop] = crop == 0 ? count : (int) ((int64_t) count * this->quotas[crop] / 100);
+
+        if (crop > 0 && this->yields[crop] > 0.0f && this->limits[crop] > 0) {
+            this->candidates.push_back(crop);
+        }
+    }
+
+    this->bounds.resize(count);
+    this->previous.resize(count);
+    for (auto& plot : farm->plots) {
+        this->bounds[plot->id] = plot->bounds;
+        this->previous[plot->id] = this->families[plot->crop->index];
+    }
+
+    this->findNeighbors(farm);
+    this->planFarm = farm;
+    this->planRegistryVersion = registry->version;
+}
+
+void RotationPlanner::start(Farm* farm, CropRegistry* registry) {
+    if (this->running()) {
+        return;
+    }
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+
+    this->snapshot(farm, registry);
+    this->annealing.cancelled = false;
+    this->finished = false;
+    this->worker = std::thread([this]() {
+        this->plan = this->optimize();
+        this->finished = true;
+    });
+}
+
+bool RotationPlanner::running() {
+    return this->worker.joinable() && !this->finished;
+}
+
+double RotationPlanner::harvestOf(int plot, int crop) {
+    return Plot::plantsFor(this->bounds[plot], this->spacings[crop]) * (double) this->yields[crop];
+}
+
+bool RotationPlanner::moveDelta(const uint16_t* crops, const int* counts, int plot, int season, int crop, double* delta) {
+    int seasons = this->seasons;
+    int old = crops[plot * seasons + season];
+    if (crop == old) {
+        return false;
+    }
+
+    if (crop != 0 && counts[season * this->cropCount + crop] >= this->limits[crop]) {
+        return false;
+    }
+
+    // the family cant have been in this plot, or come back to it, within the gap
+    int family = this->families[crop];
+    if (family >= 0) {
+        for (int distance = 1; distance <= this->gap; distance++) {
+            int before = season - distance;
+            int after = season + distance;
+            if (before >= 0 && this->families[crops[plot * seasons + before]] == family) {
+                return false;
+            }
+            if (before == -1 && this->previous[plot] == family) {
+                return false;
+            }
+            if (after < seasons && this->families[crops[plot * seasons + after]] == family) {
+                return false;
+            }
+        }
+    }
+
+    double oldHarvest = this->harvestOf(plot, old);
+    double newHarvest = this->harvestOf(plot, crop);
+    double change = newHarvest - oldHarvest;
+
+    // every neighbor pair sharing a family loses a share of both plots' harvest
+    if (this->neighborPenalty > 0.0f) {
+        double share = this->neighborPenalty / 100.0;
+        int oldFamily = this->families[old];
+
+        for (int i = this->neighborStart[plot]; i < this->neighborStart[plot + 1]; i++) {
+            int other = this->neighbors[i];
+            int otherCrop = crops[other * seasons + season];
+            int otherFamily = this->families[otherCrop];
+            if (otherFamily < 0) {
+                continue;
+            }
+
+            double otherHarvest = this->harvestOf(other, otherCrop);
+            if (otherFamily == family) {
+                change -= share * (newHarvest + otherHarvest);
+            }
+            if (otherFamily == oldFamily) {
+                change += share * (oldHarvest + otherHarvest);
+            }
+        }
+    }
+
+    *delta = change;
+    return true;
+}
+
+void RotationPlanner::anneal(Annealing::Chain& chain, Plan* plan) {
+    int plots = this->bounds.size();
+    int seasons = this->seasons;
+    int cropCount = this->cropCount;
+    int candidates = this->candidates.size();
+
+    // everything starts empty, which never breaks a gap or quota
+    std::vector<uint16_t> crops((size_t) plots * seasons, 0);
+    std::vector<int> counts(seasons * cropCount, 0);
+    for (int season = 0; season < seasons; season++) {
+        counts[season * cropCount] = plots;
+    }
+
+    std::mt19937& random = chain.random;
+    double score = 0.0;
+
+    for (int batch; (batch = this->annealing.batch(chain)) > 0;) {
+        for (int move = 0; move < batch; move++) {
+            int plot = random() % plots;
+            int season = random() % seasons;
+            int crop = this->candidates[random() % candidates];
+
+            double delta;
+            if (!this->moveDelta(crops.data(), counts.data(), plot, season, crop, &delta)) {
+                continue;
+            }
+            if (!this->annealing.accept(chain, delta)) {
+                continue;
+            }
+
+            uint16_t& slot = crops[(size_t) plot * seasons + season];
+            counts[season * cropCount + slot]--;
+            counts[season * cropCount + crop]++;
+            slot = crop;
+            score += delta;
+        }
+
+        this->annealing.report(chain, batch, score);
+    }
+
+    plan->plots = plots;
+    plan->seasons = seasons;
+    plan->crops = std::move(crops);
+    this->evaluate(plan);
+}
+
+void RotationPlanner::evaluate(Plan* plan) {
+    int seasons = plan->seasons;
+    plan->counts.assign(seasons * this->cropCount, 0);
+    plan->seasonHarvests.assign(seasons, 0.0);
+    plan->harvest = 0.0;
+    plan->penalty = 0.0;
+
+    double share = this->neighborPenalty / 100.0;
+    for (int plot = 0; plot < plan->plots; plot++) {
+        for (int season = 0; season < seasons; season++) {
+            int crop = plan->crops[(size_t) plot * seasons + season];
+            double harvest = this->harvestOf(plot, crop);
+            plan->counts[season * this->cropCount + crop]++;
+            plan->seasonHarvests[season] += harvest;
+            plan->harvest += harvest;
+
+            // each pair once, from its lower id
+            int family = this->families[crop];
+            for (int i = this->neighborStart[plot]; i < this->neighborStart[plot + 1] && family >= 0; i++) {
+                int other = this->neighbors[i];
+                int otherCrop = plan->crops[(size_t) other * seasons + season];
+                if (other > plot && this->families[otherCrop] == family) {
+                    plan->penalty += share * (harvest + this->harvestOf(other, otherCrop));
+                }
+            }
+        }
+    }
+
+    plan->score = plan->harvest - plan->penalty;
+}
+
+int RotationPlanner::violations(Plan& plan) {
+    int seasons = plan.seasons;
+    int broken = 0;
+
+    for (int plot = 0; plot < plan.plots; plot++) {
+        for (int season = 0; season < seasons; season++) {
+            int family = this->families[plan.crops[(size_t) plot * seasons + season]];
+            for (int distance = 1; distance <= this->gap && family >= 0; distance++) {
+                int before = season - distance;
+                if (before >= 0 ? this->families[plan.crops[(size_t) plot * seasons + before]] == family :
+                    before == -1 && this->previous[plot] == family) {
+                    broken++;
+                }
+            }
+        }
+    }
+
+    for (int season = 0; season < seasons; season++) {
+        for (int crop = 1; crop < this->cropCount; crop++) {
+            broken += plan.counts[season * this->cropCount + crop] > this->limits[crop];
+        }
+    }
+
+    return broken;
+}
+
+RotationPlanner::Plan RotationPlanner::optimize() {
+    auto start = std::chrono::steady_clock::now();
+
+    int plots = this->bounds.size();
+    size_t planBytes = std::max<size_t>(1, (size_t) plots * this->seasons * sizeof(uint16_t));
+    int chains = std::max(1, std::min<int>(Parallel::workerCount(), ROTATION_MEMORY_BUDGET / planBytes));
+
+    // a move swaps about one average plot's harvest of an average crop, so the temperatures suit any farm
+    double plantSum = 0.0;
+    for (SDL_Rect& bounds : this->bounds) {
+        plantSum += Plot::plantsFor(bounds, CROP_DEFAULT_SPACING);
+    }
+    double yieldSum = 0.0;
+    for (int crop : this->candidates) {
+        yieldSum += this->yields[crop];
+    }
+    double scale = std::max(1e-6, plantSum / std::max(1, plots) * yieldSum / std::max<int>(1, this->candidates.size() - 1));
+    this->annealing.begin(chains, (int64_t) this->sweeps * plots * this->seasons, ROTATION_MOVE_BATCH, scale, ROTATION_HOT, ROTATION_COLD);
+
+    std::vector<Plan> plans(chains);
+    int best = this->annealing.run(this->seed, [&](Annealing::Chain& chain) {
+        Plan& plan = plans[chain.index];
+        plan.plots = 0;
+        plan.seasons = this->seasons;
+        if (plots > 0) {
+            this->anneal(chain, &plan);
+        } else {
+            this->evaluate(&plan);
+        }
+        return plan.score;
+    });
+
+    Plan plan = std::move(plans[best]);
+    plan.chains = chains;
+    plan.seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    return plan;
+}
+
+void RotationPlanner::apply(Farm* farm, CropRegistry* registry, int season) {
+    // a reload can renumber the crops and a different farm has different plots
+    if (farm != this->planFarm || registry->version != this->planRegistryVersion || season >= this->plan.seasons) {
+        return;
+    }
+
+    farm->history.beginGroup();
+    int count = std::min((int) farm->plots.size(), this->plan.plots);
+    for (int id = 0; id < count; id++) {
+        Plot* plot = farm->plots[id];
+        int crop = this->plan.crops[(size_t) id * this->plan.seasons + season];
+        if (crop == plot->crop->index) {
+            continue;
+        }
+
+        CropRegistry::CropEntry* entry = registry->ordered[crop];
+        farm->history.recordCrop(plot, plot->crop, plot->cropIndex, entry, crop);
+        plot->updateProperties(entry, crop);
+        farm->markDirty(plot);
+    }
+    farm->history.endGroup();
+}
+
+void RotationPlanner::showQuotas(CropRegistry* registry) {
+    int count = registry->ordered.size();
+    this->quotas.resize(count, 100);
+
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.5);
+    if (ImGui::SliderInt("All Crops", &this->allQuotas, 0, 100, "%d%%")) {
+        std::fill(this->quotas.begin(), this->quotas.end(), this->allQuotas);
+    }
+
+    float height = std::min(count - 1, 8) * ImGui::GetFrameHeightWithSpacing();
+    ImGui::BeginChild("rotation_quotas", ImVec2(0, height));
+    {
+        ImGuiListClipper clipper;
+        clipper.Begin(count - 1);
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                int crop = i + 1;
+                ImGui::PushID(crop);
+                ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.5);
+                ImGui::SliderInt(registry->ordered[crop]->name.c_str(), &this->quotas[crop], 0, 100, "%d%%");
+                ImGui::PopID();
+            }
+        }
+    }
+    ImGui::EndChild();
+}
+
+void RotationPlanner::show(Farm* farm, CropRegistry* registry) {
+    ImGui::SetNextWindowSize(ImVec2(460, 520), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Crop Rotation", &this->open)) {
+        ImGui::End();
+        return;
+    }
+
+    // the finished worker is picked up here, a cancelled run has nothing worth showing
+    if (this->finished && this->worker.joinable()) {
+        this->worker.join();
+        this->hasResult = !this->annealing.cancelled;
+        this->applySeason = std::min(this->applySeason, this->plan.seasons - 1);
+    }
+
+    bool busy = this->running();
+
+    ImGui::BeginDisabled(busy);
+    ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.5);
+    ImGui::SliderInt("Seasons", &this->seasons, 1, ROTATION_MAX_SEASONS);
+    ImGui::SliderInt("Minimum Gap", &this->gap, 0, ROTATION_MAX_SEASONS - 1, "%d seasons");
+    ImGui::SliderFloat("Neighbor Penalty", &this->neighborPenalty, 0.0f, 50.0f, "%.0f%%");
+    ImGui::SliderInt("Sweeps", &this->sweeps, 10, 5000, "%d", ImGuiSliderFlags_Logarithmic);
+    ImGui::InputInt("Seed", &this->seed);
+    ImGui::PopItemWidth();
+
+    if (ImGui::TreeNode("Crop Quotas")) {
+        this->showQuotas(registry);
+        ImGui::TreePop();
+    }
+
+    if (ImGui::Button("Plan")) {
+        this->start(farm, registry);
+    }
+    ImGui::EndDisabled();
+
+    if (busy) {
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            this->annealing.cancelled = true;
+        }
+        ImGui::SameLine();
+        ImGui::ProgressBar(this->annealing.progress());
+    }
+
+    // best score of any chain at each point of the run so far
+    if (busy || this->hasResult) {
+        float curve[ANNEAL_CURVE];
+        int length = this->annealing.bestCurve(curve);
+
+        if (length > 0) {
+            ImGui::Text("Best Score: %.1f lbs", curve[length - 1]);
+            ImGui::PlotLines("##rotation_curve", curve, length, 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 60));
+        }
+    }
+
+    if (this->hasResult && !busy) {
+        Plan& plan = this->plan;
+        ImGui::SeparatorText("Plan");
+        ImGui::Text("Harvest: %.1f lbs", plan.harvest);
+        ImGui::Text("Lost To Neighbors: %.1f lbs", plan.penalty);
+        ImGui::TextDisabled("%d chains over %d plots in %.2f s", plan.chains, plan.plots, plan.seconds);
+
+        ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV | ImGuiTableFlags_SizingStretchProp;
+        if (ImGui::BeginTable("rotation_seasons", 4, flags)) {
+            ImGui::TableSetupColumn("Season", 0, 0.6f);
+            ImGui::TableSetupColumn("Planted", 0, 0.8f);
+            ImGui::TableSetupColumn("Harvest (lbs)", 0, 1.2f);
+            ImGui::TableSetupColumn("Most Planted", 0, 1.6f);
+            ImGui::TableHeadersRow();
+
+            for (int season = 0; season < plan.seasons; season++) {
+                const int* counts = &plan.counts[season * this->cropCount];
+                int top = 1;
+                for (int crop = 2; crop < this->cropCount; crop++) {
+                    top = counts[crop] > counts[top] ? crop : top;
+                }
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", season + 1);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", plan.plots - counts[0]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", plan.seasonHarvests[season]);
+                ImGui::TableNextColumn();
+                if (top < this->cropCount && top < (int) registry->ordered.size()) {
+                    ImGui::Text("%s (%d)", registry->ordered[top]->name.c_str(), counts[top]);
+                }
+            }
+
+            ImGui::EndTable();
+        }
+
+        // the plan's crop indexes are only good for the farm and crop table it was made with
+        bool stale = farm != this->planFarm || registry->version != this->planRegistryVersion;
+        ImGui::BeginDisabled(stale);
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.5);
+        int shown = this->applySeason + 1;
+        if (ImGui::SliderInt("##apply_season", &shown, 1, plan.seasons, "Season %d")) {
+            this->applySeason = shown - 1;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Apply To Farm")) {
+            this->apply(farm, registry, this->applySeason);
+        }
+        ImGui::EndDisabled();
+
+        if (stale) {
+            ImGui::TextDisabled("The farm or crops changed, plan again to apply");
+        }
+    }
+
+    ImGui::End();
+}
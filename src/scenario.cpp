@@ -0,0 +1,335 @@
+/*
+ *  scenario.cpp - headless evaluation of what-if variants of a farm
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// standard normal quantile of the 95th percentile
+#define SCENARIO_Z95 1.6448536
+
+// csv text field, always quoted so commas and quotes in names cant break the row
+static std::string csvField(const std::string& text) {
+    std::string field = "\"";
+    for (char c : text) {
+        if (c == '"') {
+            field += '"';
+        }
+        field += c;
+    }
+    return field + "\"";
+}
+
+// looks up a value of a sorted (key, value) list, or returns fallback
+template <typename T>
+static T lookup(const std::vector<std::pair<int, T>>& list, int key, T fallback) {
+    auto found = std::lower_bound(list.begin(), list.end(), std::make_pair(key, T()),
+        [](const std::pair<int, T>& a, const std::pair<int, T>& b) { return a.first < b.first; });
+    return found != list.end() && found->first == key ? found->second : fallback;
+}
+
+static double squared(double x) {
+    return x * x;
+}
+
+ScenarioBatch::ScenarioBatch(CropRegistry* registry) {
+    this->registry = registry;
+}
+
+ScenarioBatch::~ScenarioBatch() {
+    for (auto& plot : this->plots) {
+        delete plot;
+    }
+}
+
+bool ScenarioBatch::loadFarm(std::string filename) {
+    // the full json has every deviation in it, the index would leave them to a background loader
+    std::string buffer;
+    std::string farmName;
+    if (!FarmFile::readAll(filename, &buffer)) {
+        printf("ERROR: UNABLE TO OPEN %s\n", filename.c_str());
+        return false;
+    }
+    if (!FarmFile::load(buffer, this->registry, &farmName, &this->plots, nullptr)) {
+        return false;
+    }
+
+    int cropCount = this->registry->ordered.size();
+    int count = this->plots.size();
+    this->bounds.resize(count);
+    this->crops.resize(count);
+    this->deviances.resize(count);
+    this->cropPlants.assign(cropCount, 0);
+    this->cropSpread.assign(cropCount, 0.0);
+
+    this->yields.resize(cropCount);
+    this->spacings.resize(cropCount);
+    for (int crop = 0; crop < cropCount; crop++) {
+        this->yields[crop] = this->registry->ordered[crop]->avgYield;
+        this->spacings[crop] = this->registry->ordered[crop]->spacing;
+    }
+
+    for (auto& plot : this->plots) {
+        int id = plot->id;
+        this->bounds[id] = plot->bounds;
+        this->crops[id] = plot->crop->index;
+        this->deviances[id] = plot->yieldDeviance;
+        this->plotsByName[plot->plotName].push_back(id);
+
+        int64_t plants = this->plantsOf(id, this->crops[id]);
+        this->cropPlants[this->crops[id]] += plants;
+        this->cropSpread[this->crops[id]] += squared(plants * this->deviances[id] / 100.0);
+    }
+
+    // crops that share a spacing fill the farm the same way, so there is one pass per spacing, not per crop
+    std::map<int, std::pair<int64_t, double>> bySpacing;
+    for (int spacing : this->spacings) {
+        bySpacing[spacing] = {0, 0.0};
+    }
+    for (auto& [spacing, totals] : bySpacing) {
+        for (int id = 0; id < count; id++) {
+            int64_t plants = Plot::plantsFor(this->bounds[id], spacing);
+            totals.first += plants;
+            totals.second += squared(plants * this->deviances[id] / 100.0);
+        }
+    }
+    this->everywherePlants.resize(cropCount);
+    this->everywhereSpread.resize(cropCount);
+    for (int crop = 0; crop < cropCount; crop++) {
+        this->everywherePlants[crop] = bySpacing[this->spacings[crop]].first;
+        this->everywhereSpread[crop] = bySpacing[this->spacings[crop]].second;
+    }
+
+    printf("farm %s: %d plots, %d crops\n", farmName.c_str(), count, cropCount);
+    return true;
+}
+
+ScenarioBatch::Scenario ScenarioBatch::parse(const std::string& line, Json::CharReader* reader) {
+    Scenario scenario = {};
+    scenario.crop = -1;
+    scenario.devianceScale = 1.0;
+
+    Json::Value data;
+    std::string errors;
+    if (!reader->parse(line.data(), line.data() + line.size(), &data, &errors) || !data.isObject()) {
+        scenario.error = "not a json object";
+        return scenario;
+    }
+
+    // names that arent in the farm or crop table are counted and skipped, the rest of the line still counts
+    auto cropIndex = [&](const Json::Value& value) {
+        CropRegistry::CropEntry* entry = value.isString() ? this->registry->access(value.asString()) : nullptr;
+        scenario.unknown += entry == nullptr;
+        return entry ? entry->index : -1;
+    };
+
+    const Json::Value& name = data["name"];
+    if (!name.isNull() && !name.isString()) {
+        scenario.error = "name is not a string";
+        return scenario;
+    }
+    scenario.name = name.asString();
+
+    if (data.isMember("crop")) {
+        scenario.crop = cropIndex(data["crop"]);
+    }
+
+    if (data.isMember("devianceScale")) {
+        if (!data["devianceScale"].isNumeric()) {
+            scenario.error = "devianceScale is not a number";
+            return scenario;
+        }
+        scenario.devianceScale = data["devianceScale"].asDouble();
+    }
+
+    const Json::Value& plots = data["plots"];
+    for (auto it = plots.begin(); plots.isObject() && it != plots.end(); it++) {
+        auto found = this->plotsByName.find(it.name());
+        int crop = cropIndex(*it);
+        if (found == this->plotsByName.end()) {
+            scenario.unknown++;
+        } else if (crop >= 0) {
+            for (int id : found->second) {
+                scenario.plotCrops.push_back({id, crop});
+            }
+        }
+    }
+
+    const Json::Value& deviances = data["deviances"];
+    for (auto it = deviances.begin(); deviances.isObject() && it != deviances.end(); it++) {
+        if (!it->isNumeric()) {
+            scenario.error = "deviance of " + it.name() + " is not a number";
+            return scenario;
+        }
+
+        auto found = this->plotsByName.find(it.name());
+        if (found == this->plotsByName.end()) {
+            scenario.unknown++;
+            continue;
+        }
+        for (int id : found->second) {
+            scenario.deviances.push_back({id, it->asFloat()});
+        }
+    }
+
+    const Json::Value& yields = data["yields"];
+    for (auto it = yields.begin(); yields.isObject() && it != yields.end(); it++) {
+        if (!it->isNumeric()) {
+            scenario.error = "yield of " + it.name() + " is not a number";
+            return scenario;
+        }
+
+        CropRegistry::CropEntry* entry = this->registry->access(it.name());
+        if (entry == nullptr) {
+            scenario.unknown++;
+            continue;
+        }
+        scenario.yields.push_back({entry->index, it->asDouble()});
+    }
+
+    std::sort(scenario.plotCrops.begin(), scenario.plotCrops.end());
+    std::sort(scenario.deviances.begin(), scenario.deviances.end());
+    std::sort(scenario.yields.begin(), scenario.yields.end());
+    return scenario;
+}
+
+int64_t ScenarioBatch::plantsOf(int plot, int crop) {
+    return Plot::plantsFor(this->bounds[plot], this->spacings[crop]);
+}
+
+// the totals kept per crop make a scenario cost its overrides plus one pass over the crops, not a pass over the farm
+ScenarioBatch::Result ScenarioBatch::evaluate(Scenario& scenario, std::vector<int64_t>& plants, std::vector<double>& spread) {
+    int cropCount = this->yields.size();
+
+    if (scenario.crop >= 0) {
+        plants.assign(cropCount, 0);
+        spread.assign(cropCount, 0.0);
+        plants[scenario.crop] = this->everywherePlants[scenario.crop];
+        spread[scenario.crop] = this->everywhereSpread[scenario.crop];
+    } else {
+        plants = this->cropPlants;
+        spread = this->cropSpread;
+    }
+
+    // deviances change first, under whatever crop the plot has before any switch
+    for (auto& [id, deviance] : scenario.deviances) {
+        int crop = scenario.crop >= 0 ? scenario.crop : this->crops[id];
+        int64_t count = this->plantsOf(id, crop);
+        spread[crop] += squared(count * deviance / 100.0) - squared(count * this->deviances[id] / 100.0);
+    }
+
+    // then switched plots move over to the new crop, replanted at its spacing
+    for (auto& [id, crop] : scenario.plotCrops) {
+        int from = scenario.crop >= 0 ? scenario.crop : this->crops[id];
+        double deviance = lookup(scenario.deviances, id, this->deviances[id]) / 100.0;
+        int64_t fromPlants = this->plantsOf(id, from);
+        int64_t toPlants = this->plantsOf(id, crop);
+        plants[from] -= fromPlants;
+        spread[from] -= squared(fromPlants * deviance);
+        plants[crop] += toPlants;
+        spread[crop] += squared(toPlants * deviance);
+    }
+
+    Result result = {};
+    double variance = 0.0;
+    for (int crop = 0; crop < cropCount; crop++) {
+        double yield = lookup(scenario.yields, crop, this->yields[crop]);
+        result.plants += plants[crop];
+        result.harvest += yield * plants[crop];
+        variance += yield * yield * spread[crop];
+    }
+
+    // taking shares back off can leave a hair below zero
+    result.deviation = sqrt(std::max(variance, 0.0)) * fabs(scenario.devianceScale);
+    result.low = std::max(0.0, result.harvest - SCENARIO_Z95 * result.deviation);
+    result.high = result.harvest + SCENARIO_Z95 * result.deviation;
+    return result;
+}
+
+int ScenarioBatch::run(std::string scenarioFile, std::string outputFile) {
+    std::ifstream input(scenarioFile);
+    if (!input) {
+        printf("ERROR: UNABLE TO OPEN %s\n", scenarioFile.c_str());
+        return 1;
+    }
+
+    FILE* output = fopen(outputFile.c_str(), "w");
+    if (output == nullptr) {
+        printf("ERROR: UNABLE TO WRITE %s\n", outputFile.c_str());
+        return 1;
+    }
+    fprintf(output, "line,name,plants,harvest_lbs,deviation_lbs,p5_lbs,p95_lbs,unknown_names,error\n");
+
+    auto start = std::chrono::steady_clock::now();
+    float evaluateSeconds = 0.0f;
+    int64_t evaluated = 0;
+    int64_t failed = 0;
+    int lineNumber = 0;
+
+    // reused for every chunk, so memory stays flat however long the file is
+    std::vector<std::string> lines(SCENARIO_CHUNK);
+    std::vector<int> lineNumbers(SCENARIO_CHUNK);
+    std::vector<Scenario> scenarios(SCENARIO_CHUNK);
+    std::vector<Result> results(SCENARIO_CHUNK);
+
+    while (input) {
+        // blank lines are skipped but still counted, so rows point back at the right line
+        int count = 0;
+        while (count < SCENARIO_CHUNK && std::getline(input, lines[count])) {
+            lineNumber++;
+            if (lines[count].find_first_not_of(" \t\r") != std::string::npos) {
+                lineNumbers[count++] = lineNumber;
+            }
+        }
+        if (count == 0) {
+            break;
+        }
+
+        auto chunkStart = std::chrono::steady_clock::now();
+        Parallel::forRange(count, SCENARIO_BLOCK, [&](int begin, int end) {
+            Json::CharReaderBuilder builder;
+            std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+            std::vector<int64_t> plants;
+            std::vector<double> spread;
+
+            // anything jsoncpp throws on a strange line goes in that line's error column, a throw
+            // out of a worker would end the whole batch
+            for (int i = begin; i < end; i++) {
+                try {
+                    scenarios[i] = this->parse(lines[i], reader.get());
+                } catch (std::exception& error) {
+                    scenarios[i] = Scenario{};
+                    scenarios[i].error = error.what();
+                }
+                results[i] = scenarios[i].error.empty() ? this->evaluate(scenarios[i], plants, spread) : Result{};
+            }
+        });
+        evaluateSeconds += std::chrono::duration<float>(std::chrono::steady_clock::now() - chunkStart).count();
+
+        // rows go out a chunk at a time in file order
+        for (int i = 0; i < count; i++) {
+            Scenario& scenario = scenarios[i];
+            Result& result = results[i];
+            if (!scenario.error.empty()) {
+                fprintf(output, "%d,%s,,,,,,,%s\n", lineNumbers[i], csvField(scenario.name).c_str(), csvField(scenario.error).c_str());
+                failed++;
+                continue;
+            }
+
+            fprintf(output, "%d,%s,%lld,%.2f,%.2f,%.2f,%.2f,%d,\n", lineNumbers[i], csvField(scenario.name).c_str(), (long long) result.plants,
+                result.harvest, result.deviation, result.low, result.high, scenario.unknown);
+        }
+        evaluated += count;
+    }
+
+    fclose(output);
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    printf("evaluated %lld scenarios in %.2f s using %d threads, %.0f scenarios/s (%.0f scenarios/s not counting reading and writing)\n",
+        (long long) evaluated, seconds, Parallel::workerCount(), evaluated / std::max(seconds, 1e-6f), evaluated / std::max(evaluateSeconds, 1e-6f));
+    if (failed > 0) {
+        printf("ERROR: %lld SCENARIOS COULDNT BE READ, SEE THE ERROR COLUMN OF %s\n", (long long) failed, outputFile.c_str());
+    }
+
+    return failed > 0 ? 1 : 0;
+}
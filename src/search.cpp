@@ -0,0 +1,249 @@
+/*
+ *  search.cpp - prefix and trigram index for searching lists of names
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// three lowercase bytes packed into one key
+static uint32_t trigramAt(std::string_view text, size_t i) {
+    return ((uint8_t) text[i] << 16) | ((uint8_t) text[i + 1] << 8) | (uint8_t) text[i + 2];
+}
+
+static std::string lowercase(std::string text) {
+    for (char& c : text) {
+        c = tolower((unsigned char) c);
+    }
+    return text;
+}
+
+SearchIndex::SearchIndex() {
+    this->generation = 0;
+}
+
+// the generation keeps counting from this index's, so queries made against the old names see they are stale
+void SearchIndex::adopt(SearchIndex& other) {
+    this->text.swap(other.text);
+    this->offsets.swap(other.offsets);
+    this->order.swap(other.order);
+    this->trigrams.swap(other.trigrams);
+    this->generation++;
+
+    other.text.clear();
+    other.offsets.clear();
+    other.order.clear();
+    other.trigrams.clear();
+}
+
+SearchQuery::SearchQuery() {
+    this->generation = -1;
+}
+
+void SearchIndex::build(const std::vector<std::string>& names) {
+    this->text.clear();
+    this->offsets.clear();
+    this->trigrams.clear();
+    this->generation++;
+
+    // every lowercased name goes back to back into one buffer, checking a name is then a single cache miss
+    size_t total = 0;
+    for (auto& name : names) {
+        total += name.size();
+    }
+
+    this->text.reserve(total);
+    this->offsets.reserve(names.size() + 1);
+    for (auto& name : names) {
+        this->offsets.push_back(this->text.size());
+        for (char c : name) {
+            this->text += tolower((unsigned char) c);
+        }
+    }
+    this->offsets.push_back(this->text.size());
+
+    // ids sorted by name, prefix queries are a binary search in here
+    std::vector<std::pair<uint64_t, int>> keys(names.size());
+    for (int id = 0; id < this->size(); id++) {
+        keys[id] = {0, id};
+    }
+    this->sortNames(keys, 0, keys.size(), 0);
+
+    this->order.resize(names.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        this->order[i] = keys[i].second;
+    }
+
+    // ids go in ascending, so every posting list comes out sorted
+    for (int id = 0; id < this->size(); id++) {
+        std::string_view name = this->name(id);
+        for (size_t i = 0; i + 3 <= name.size(); i++) {
+            std::vector<int>& postings = this->trigrams[trigramAt(name, i)];
+            // a trigram that shows up twice in one name only needs one entry
+            if (postings.empty() || postings.back() != id) {
+                postings.push_back(id);
+            }
+        }
+    }
+}
+
+// eight bytes of a name starting at depth as a big endian number, names that end early are padded with zeros
+uint64_t SearchIndex::nameKey(int id, size_t depth) {
+    std::string_view name = this->name(id);
+    uint64_t key = 0;
+    for (size_t i = depth; i < depth + 8; i++) {
+        key = (key << 8) | (i < name.size() ? (uint8_t) name[i] : 0);
+    }
+    return key;
+}
+
+// sorts by eight bytes of the names at a time, going deeper only into runs that are still tied
+// comparing integers keeps the sort from going out to the text on every comparison
+void SearchIndex::sortNames(std::vector<std::pair<uint64_t, int>>& keys, size_t first, size_t last, size_t depth) {
+    bool longer = false;
+    for (size_t i = first; i < last; i++) {
+        keys[i].first = this->nameKey(keys[i].second, depth);
+        longer |= this->offsets[keys[i].second + 1] - this->offsets[keys[i].second] > depth + 8;
+    }
+    std::sort(keys.begin() + first, keys.begin() + last);
+
+    // every name in the range ended, the ties are equal names and stay in id order
+    if (!longer) {
+        return;
+    }
+
+    while (first < last) {
+        size_t end = first + 1;
+        while (end < last && keys[end].first == keys[first].first) {
+            end++;
+        }
+        if (end - first > 1) {
+            this->sortNames(keys, first, end, depth + 8);
+        }
+        first = end;
+    }
+}
+
+int SearchIndex::size() {
+    return (int) this->offsets.size() - 1;
+}
+
+std::string_view SearchIndex::name(int id) {
+    return std::string_view(this->text.data() + this->offsets[id], this->offsets[id + 1] - this->offsets[id]);
+}
+
+bool SearchIndex::matches(std::string_view name, const std::string& query) {
+    if (query.size() < 3) {
+        return name.substr(0, query.size()) == query;
+    }
+    return name.find(query) != std::string_view::npos;
+}
+
+bool SearchIndex::matches(int id, const std::string& query) {
+    return SearchIndex::matches(this->name(id), query);
+}
+
+void SearchIndex::find(std::string query, std::vector<int>* out) {
+    query = lowercase(query);
+    out->clear();
+
+    // nothing typed yet, everything matches
+    if (query.empty()) {
+        out->resize(this->size());
+        std::iota(out->begin(), out->end(), 0);
+        return;
+    }
+
+    // too short for a trigram, names starting with it sit next to each other in the sorted order
+    if (query.size() < 3) {
+        auto first = std::lower_bound(this->order.begin(), this->order.end(), query, [&](int id, const std::string& value) {
+            return this->name(id).substr(0, value.size()) < value;
+        });
+        auto last = std::upper_bound(first, this->order.end(), query, [&](const std::string& value, int id) {
+            return value < this->name(id).substr(0, value.size());
+        });
+
+        // a small range is quicker to sort, a big one is quicker to mark off and sweep in id order
+        if ((last - first) * 16 < (long) this->size()) {
+            out->assign(first, last);
+            std::sort(out->begin(), out->end());
+        } else {
+            std::vector<bool> marked(this->size());
+            for (auto at = first; at != last; at++) {
+                marked[*at] = true;
+            }
+
+            out->reserve(last - first);
+            for (int id = 0; id < (int) marked.size(); id++) {
+                if (marked[id]) {
+                    out->push_back(id);
+                }
+            }
+        }
+        return;
+    }
+
+    // every trigram of the query has to be in the name, a missing one means nothing matches
+    std::vector<std::vector<int>*> lists;
+    for (size_t i = 0; i + 3 <= query.size(); i++) {
+        auto found = this->trigrams.find(trigramAt(query, i));
+        if (found == this->trigrams.end()) {
+            return;
+        }
+        lists.push_back(&found->second);
+    }
+
+    // start from the rarest trigram and look the candidates up in the rest
+    std::sort(lists.begin(), lists.end(), [](std::vector<int>* a, std::vector<int>* b) {
+        return a->size() < b->size();
+    });
+
+    for (int id : *lists[0]) {
+        bool inAll = true;
+        for (size_t i = 1; i < lists.size() && inAll; i++) {
+            inAll = std::binary_search(lists[i]->begin(), lists[i]->end(), id);
+        }
+
+        // the trigrams could be spread around the name, so check it really contains the query
+        if (inAll && this->matches(id, query)) {
+            out->push_back(id);
+        }
+    }
+}
+
+void SearchIndex::update(SearchQuery* query, const char* typed) {
+    // results from before a rebuild point at the old ids
+    bool valid = query->generation == this->generation;
+
+    // called every frame the picker is open, so an unchanged query is checked without copying it
+    size_t length = strlen(typed);
+    if (valid && length == query->text.size()) {
+        size_t i = 0;
+        while (i < length && tolower((unsigned char) typed[i]) == query->text[i]) {
+            i++;
+        }
+        if (i == length) {
+            return;
+        }
+    }
+
+    std::string text = lowercase(typed);
+
+    // typing more only ever removes results, as long as both are the same kind of query
+    bool samePrefix = query->text.size() < 3 && text.size() < 3 && text.compare(0, query->text.size(), query->text) == 0;
+    bool sameSubstring = query->text.size() >= 3 && text.find(query->text) != std::string::npos;
+
+    if (valid && !query->text.empty() && (samePrefix || sameSubstring)) {
+        int kept = 0;
+        for (int id : query->results) {
+            if (this->matches(id, text)) {
+                query->results[kept++] = id;
+            }
+        }
+        query->results.resize(kept);
+    } else {
+        this->find(text, &query->results);
+    }
+
+    query->text = text;
+    query->generation = this->generation;
+}
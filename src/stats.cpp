@@ -0,0 +1,175 @@
+/*
+ *  stats.cpp - farm wide yield totals kept up to date as plots change
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+FarmStats::FarmStats() {
+    this->open = false;
+    this->farm = nullptr;
+    this->farmVersion = 0;
+    this->registryVersion = -1;
+    this->detailsDone = false;
+    this->total = {};
+}
+
+void FarmStats::reset() {
+    this->farm = nullptr;
+}
+
+void FarmStats::Totals::add(const Totals& other, int sign) {
+    this->plots += other.plots * sign;
+    this->area += other.area * sign;
+    this->plants += other.plants * sign;
+    this->harvest += other.harvest * sign;
+    this->variance += other.variance * sign;
+}
+
+double FarmStats::Totals::harvestLbs() {
+    return (double) this->harvest / STATS_HARVEST_SCALE;
+}
+
+double FarmStats::Totals::deviationLbs() {
+    return sqrt((double) this->variance) / STATS_DEVIATION_SCALE;
+}
+
+// one plot's share of the totals, everything rounded to fixed point here so that
+// taking it back off later removes exactly what was added
+FarmStats::Totals FarmStats::contributionOf(Plot* plot) {
+    Totals totals = {};
+    totals.plots = 1;
+    totals.area = (int64_t) plot->bounds.w * plot->bounds.h;
+    totals.plants = plot->plantCount();
+
+    double harvest = plot->expectedHarvest();
+    totals.harvest = llround(harvest * STATS_HARVEST_SCALE);
+
+    // deviation is a percentage of the harvest, plots still loading their details count as exact
+    // a deviation too big to round, or not a number at all, is capped before it can overflow
+    if (plot->hasDetails()) {
+        double scaled = fabs(harvest * plot->yieldDeviance / 100.0 * STATS_DEVIATION_SCALE);
+        scaled = std::isnan(scaled) ? 0.0 : std::min(scaled, STATS_MAX_DEVIATION);
+        int64_t deviation = llround(scaled);
+        totals.variance = (__int128) deviation * deviation;
+    }
+
+    return totals;
+}
+
+void FarmStats::refreshPlot(Plot* plot) {
+    int id = plot->id;
+    Totals next = this->contributionOf(plot);
+    int crop = plot->crop->index;
+
+    // the old share comes off whichever crop it was counted under, the new one goes on the current crop
+    this->total.add(this->plots[id], -1);
+    this->byCrop[this->crops[id]].add(this->plots[id], -1);
+
+    this->plots[id] = next;
+    this->crops[id] = crop;
+    this->total.add(next, 1);
+    this->byCrop[crop].add(next, 1);
+}
+
+void FarmStats::refresh(Farm* farm, CropRegistry* registry) {
+    bool detailsDone = farm->detailLoader == nullptr || farm->detailLoader->done();
+
+    // a different farm, reloaded crops or the deviations coming in touch everything
+    if (farm != this->farm || registry->version != this->registryVersion || detailsDone != this->detailsDone) {
+        this->total = {};
+        this->byCrop.assign(registry->ordered.size(), Totals{});
+        this->plots.assign(farm->plots.size(), Totals{});
+        this->crops.assign(farm->plots.size(), 0);
+
+        for (auto& plot : farm->plots) {
+            plot->syncCrop();
+            this->refreshPlot(plot);
+        }
+
+        this->farm = farm;
+        this->farmVersion = farm->version;
+        this->registryVersion = registry->version;
+        this->detailsDone = detailsDone;
+        return;
+    }
+
+    if (farm->version == this->farmVersion) {
+        return;
+    }
+
+    // new plots start out contributing nothing, so adding them is the same as changing them
+    for (int id = this->plots.size(); id < (int) farm->plots.size(); id++) {
+        this->plots.push_back(Totals{});
+        this->crops.push_back(0);
+        this->refreshPlot(farm->plots[id]);
+    }
+
+    this->changed.clear();
+    farm->changedSince(this->farmVersion, &this->changed);
+    for (int id : this->changed) {
+        this->refreshPlot(farm->plots[id]);
+    }
+    this->farmVersion = farm->version;
+}
+
+void FarmStats::show(Farm* farm, CropRegistry* registry) {
+    this->refresh(farm, registry);
+
+    ImGui::Text("Expected Harvest: %.1f lbs", this->total.harvestLbs());
+    ImGui::Text("Deviation: %.1f lbs%s", this->total.deviationLbs(), this->detailsDone ? "" : " (loading)");
+    ImGui::Text("Plants: %lld", (long long) this->total.plants);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("By Crop")) {
+        this->open = !this->open;
+    }
+
+    if (this->open) {
+        this->showCrops(registry);
+    }
+}
+
+void FarmStats::showCrops(CropRegistry* registry) {
+    ImGui::SetNextWindowSize(ImVec2(480, 320), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Yield By Crop", &this->open)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV |
+        ImGuiTableFlags_Resizable | ImGuiTableFlags_SizingStretchProp;
+
+    if (ImGui::BeginTable("crops", 5, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Crop", 0, 2.0f);
+        ImGui::TableSetupColumn("Plots", 0, 1.0f);
+        ImGui::TableSetupColumn("Area", 0, 1.0f);
+        ImGui::TableSetupColumn("Harvest (lbs)", 0, 1.2f);
+        ImGui::TableSetupColumn("Deviation (lbs)", 0, 1.2f);
+        ImGui::TableHeadersRow();
+
+        // crops nothing is planted with are left out
+        for (int crop = 0; crop < (int) this->byCrop.size(); crop++) {
+            Totals& totals = this->byCrop[crop];
+            if (totals.plots == 0) {
+                continue;
+            }
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(registry->ordered[crop]->name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%lld", (long long) totals.plots);
+            ImGui::TableNextColumn();
+            ImGui::Text("%lld", (long long) totals.area);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", totals.harvestLbs());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", totals.deviationLbs());
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
@@ -0,0 +1,336 @@
+/*
+ *  table.cpp - sortable and filterable table of every plot in a farm
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+// columns of the table, also the bits refreshRow reports changes with
+#define TABLE_COLUMN_NAME 0
+#define TABLE_COLUMN_CROP 1
+#define TABLE_COLUMN_AREA 2
+#define TABLE_COLUMN_PLANTS 3
+#define TABLE_COLUMN_HARVEST 4
+#define TABLE_COLUMN_DEVIATION 5
+#define TABLE_COLUMN_COUNT 6
+
+PlotTable::PlotTable() {
+    this->open = false;
+    this->farm = nullptr;
+    this->farmVersion = 0;
+    this->registryVersion = -1;
+    this->plotCount = 0;
+    this->detailsDone = false;
+    this->sortColumn = TABLE_COLUMN_NAME;
+    this->ascending = true;
+    this->sortDirty = true;
+    this->filterDirty = true;
+    this->cropFilter = 0;
+    memset(this->nameFilter, 0, sizeof(this->nameFilter));
+}
+
+void PlotTable::reset() {
+    this->farm = nullptr;
+}
+
+int PlotTable::refreshRow(Plot* plot) {
+    int id = plot->id;
+    int changed = 0;
+
+    // names are lowercased here so filtering and sorting dont have to
+    char name[sizeof(plot->plotName)] = {};
+    if (plot->hasDetails()) {
+        for (int i = 0; plot->plotName[i] && i < (int) sizeof(name) - 1; i++) {
+            name[i] = tolower((unsigned char) plot->plotName[i]);
+        }
+    }
+
+    if (this->names[id] != name) {
+        this->names[id] = name;
+        changed |= 1 << TABLE_COLUMN_NAME;
+    }
+
+    // every other column is a number, compared and stored the same way
+    auto store = [&](auto& column, auto value, int bit) {
+        if (column[id] != value) {
+            column[id] = value;
+            changed |= 1 << bit;
+        }
+    };
+
+    store(this->crops, plot->crop->index, TABLE_COLUMN_CROP);
+    store(this->areas, plot->bounds.w * plot->bounds.h, TABLE_COLUMN_AREA);
+    store(this->plants, plot->plantCount(), TABLE_COLUMN_PLANTS);
+    store(this->harvests, (float) plot->expectedHarvest(), TABLE_COLUMN_HARVEST);
+    store(this->deviations, plot->yieldDeviance, TABLE_COLUMN_DEVIATION);
+
+    return changed;
+}
+
+void PlotTable::refresh(Farm* farm, CropRegistry* registry) {
+    bool detailsDone = farm->detailLoader == nullptr || farm->detailLoader->done();
+
+    // anything that can change every plot at once means starting over
+    if (farm != this->farm || (int) farm->plots.size() != this->plotCount || registry->version != this->registryVersion || detailsDone != this->detailsDone) {
+        int count = farm->plots.size();
+        this->names.assign(count, std::string());
+        this->crops.assign(count, -1);
+        this->areas.assign(count, -1);
+        this->plants.assign(count, -1);
+        this->harvests.assign(count, -1.0f);
+        this->deviations.assign(count, -1.0f);
+
+        for (auto& plot : farm->plots) {
+            plot->syncCrop();
+            this->refreshRow(plot);
+        }
+
+        this->farm = farm;
+        this->farmVersion = farm->version;
+        this->registryVersion = registry->version;
+        this->plotCount = count;
+        this->detailsDone = detailsDone;
+        this->sortDirty = true;
+        return;
+    }
+
+    if (farm->version == this->farmVersion) {
+        return;
+    }
+
+    // only plots changed since the last refresh are copied again
+    int columns = 0;
+    this->changed.clear();
+    farm->changedSince(this->farmVersion, &this->changed);
+    for (int id : this->changed) {
+        columns |= this->refreshRow(farm->plots[id]);
+    }
+    this->farmVersion = farm->version;
+
+    // dragging a plot around changes none of the columns, so it never resorts
+    if (columns & (1 << this->sortColumn)) {
+        this->sortDirty = true;
+    }
+    if (columns & ((1 << TABLE_COLUMN_NAME) | (1 << TABLE_COLUMN_CROP))) {
+        this->filterDirty = true;
+    }
+}
+
+// sortable bits of a float, bigger floats give bigger integers
+static uint32_t floatKey(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+// first eight bytes of a name as a big endian number, comparing two of them compares the prefixes
+static uint64_t namePrefix(const std::string& name) {
+    uint64_t prefix = 0;
+    for (int i = 0; i < 8; i++) {
+        prefix = (prefix << 8) | (i < (int) name.size() ? (uint8_t) name[i] : 0);
+    }
+    return prefix;
+}
+
+void PlotTable::sort() {
+    int count = this->plotCount;
+    this->sorted.resize(count);
+
+    if (this->sortColumn == TABLE_COLUMN_NAME) {
+        // most comparisons are settled by the prefixes, only equal ones look at the strings
+        std::vector<std::pair<uint64_t, int>> keys(count);
+        for (int i = 0; i < count; i++) {
+            keys[i] = {namePrefix(this->names[i]), i};
+        }
+
+        std::sort(keys.begin(), keys.end(), [&](const std::pair<uint64_t, int>& a, const std::pair<uint64_t, int>& b) {
+            if (a.first != b.first) {
+                return a.first < b.first;
+            }
+            int order = this->names[a.second].compare(this->names[b.second]);
+            return order != 0 ? order < 0 : a.second < b.second;
+        });
+
+        for (int i = 0; i < count; i++) {
+            this->sorted[i] = keys[i].second;
+        }
+    } else {
+        // every numeric column turns into a 32 bit key, ids start in order and the sort is stable
+        std::vector<uint32_t> keys(count);
+        for (int i = 0; i < count; i++) {
+            switch (this->sortColumn) {
+                case TABLE_COLUMN_CROP: keys[i] = this->crops[i]; break;
+                case TABLE_COLUMN_AREA: keys[i] = this->areas[i]; break;
+                case TABLE_COLUMN_PLANTS: keys[i] = this->plants[i]; break;
+                case TABLE_COLUMN_HARVEST: keys[i] = floatKey(this->harvests[i]); break;
+                case TABLE_COLUMN_DEVIATION: keys[i] = floatKey(this->deviations[i]); break;
+            }
+        }
+
+        // two passes of a 16 bit radix sort, low half first
+        std::vector<int> from(count);
+        std::iota(from.begin(), from.end(), 0);
+        std::vector<int> counts(1 << 16);
+
+        for (int shift = 0; shift < 32; shift += 16) {
+            std::fill(counts.begin(), counts.end(), 0);
+            for (int i = 0; i < count; i++) {
+                counts[(keys[i] >> shift) & 0xFFFF]++;
+            }
+
+            int offset = 0;
+            for (int& bucket : counts) {
+                int size = bucket;
+                bucket = offset;
+                offset += size;
+            }
+
+            for (int id : from) {
+                this->sorted[counts[(keys[id] >> shift) & 0xFFFF]++] = id;
+            }
+            from.swap(this->sorted);
+        }
+
+        this->sorted.swap(from);
+    }
+
+    if (!this->ascending) {
+        std::reverse(this->sorted.begin(), this->sorted.end());
+    }
+
+    this->sortDirty = false;
+    this->filterDirty = true;
+}
+
+void PlotTable::filter() {
+    int count = this->plotCount;
+
+    std::string text = this->nameFilter;
+    for (char& c : text) {
+        c = tolower((unsigned char) c);
+    }
+
+    // rows are checked in id order, which keeps the reads sequential, then picked out in sort order
+    std::vector<char> keep(count);
+    for (int id = 0; id < count; id++) {
+        keep[id] = (this->cropFilter == 0 || this->crops[id] == this->cropFilter) &&
+            (text.empty() || this->names[id].find(text) != std::string::npos);
+    }
+
+    this->rows.clear();
+    for (int id : this->sorted) {
+        if (keep[id]) {
+            this->rows.push_back(id);
+        }
+    }
+
+    this->filterDirty = false;
+}
+
+void PlotTable::show(Farm* farm, CropRegistry* registry, PlotWindows* windows) {
+    ImGui::SetNextWindowSize(ImVec2(640, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Plot Table", &this->open)) {
+        ImGui::End();
+        return;
+    }
+
+    this->refresh(farm, registry);
+
+    // filters
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.5);
+    if (ImGui::InputTextWithHint("##namefilter", "Filter by name", this->nameFilter, sizeof(this->nameFilter))) {
+        this->filterDirty = true;
+    }
+
+    // the crop table can be huge, so the list is clipped too
+    std::vector<CropRegistry::CropEntry*>& ordered = registry->ordered;
+    if (this->cropFilter >= (int) ordered.size()) {
+        this->cropFilter = 0;
+    }
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    if (ImGui::BeginCombo("##cropfilter", this->cropFilter == 0 ? "All crops" : ordered[this->cropFilter]->name.c_str(), ImGuiComboFlags_HeightLarge)) {
+        ImGuiListClipper clipper;
+        clipper.Begin(ordered.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                ImGui::PushID(i);
+                // index 0 is NO SELECTION, which doubles as no filter
+                if (ImGui::Selectable(i == 0 ? "All crops" : ordered[i]->name.c_str(), i == this->cropFilter)) {
+                    this->cropFilter = i;
+                    this->filterDirty = true;
+                }
+                ImGui::PopID();
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+        ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable | ImGuiTableFlags_SizingStretchProp;
+
+    // leaves a line under the table for the row count
+    if (ImGui::BeginTable("plots", TABLE_COLUMN_COUNT, flags, ImVec2(0, -ImGui::GetFrameHeightWithSpacing()))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_DefaultSort, 2.0f);
+        ImGui::TableSetupColumn("Crop", 0, 1.5f);
+        ImGui::TableSetupColumn("Area", 0, 1.0f);
+        ImGui::TableSetupColumn("Plants", 0, 1.0f);
+        ImGui::TableSetupColumn("Harvest (lbs)", 0, 1.2f);
+        ImGui::TableSetupColumn("Deviation", 0, 1.0f);
+        ImGui::TableHeadersRow();
+
+        // the header only reports a change when it was clicked
+        ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs();
+        if (specs && specs->SpecsDirty && specs->SpecsCount > 0) {
+            this->sortColumn = specs->Specs[0].ColumnIndex;
+            this->ascending = specs->Specs[0].SortDirection != ImGuiSortDirection_Descending;
+            this->sortDirty = true;
+            specs->SpecsDirty = false;
+        }
+
+        if (this->sortDirty) {
+            this->sort();
+        }
+        if (this->filterDirty) {
+            this->filter();
+        }
+
+        ImGuiListClipper clipper;
+        clipper.Begin(this->rows.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                int id = this->rows[i];
+                Plot* plot = farm->plots[id];
+
+                ImGui::TableNextRow();
+                ImGui::PushID(id);
+
+                // clicking anywhere on the row opens the plot's config window
+                ImGui::TableNextColumn();
+                if (ImGui::Selectable(plot->hasDetails() ? plot->plotName : "Loading...", windows->isOpen(plot), ImGuiSelectableFlags_SpanAllColumns)) {
+                    windows->open(plot);
+                }
+
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(plot->crop->name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", this->areas[id]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", this->plants[id]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", this->harvests[id]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f%%", this->deviations[id]);
+
+                ImGui::PopID();
+            }
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::Text("Showing %d of %d plots", (int) this->rows.size(), this->plotCount);
+    ImGui::End();
+}
@@ -0,0 +1,271 @@
+/*
+ *  watcher.cpp - reloading the crop table when its file changes
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+CropWatcher::CropWatcher(std::string filename, CropRegistry* registry) {
+    this->filename = filename;
+    this->stopping = false;
+    this->pendingReorder = false;
+    this->notify = -1;
+
+    // start from what is loaded right now
+    for (auto& pair : registry->registry) {
+        CropRegistry::CropEntry* entry = pair.second;
+        this->known[pair.first] = (CropChange){entry->name, entry->avgYield, entry->color, entry->growthDays, entry->plantingDay, entry->family, entry->spacing};
+    }
+
+    // watch before the worker starts so a save made right after startup is still seen
+    if (!this->watch()) {
+        printf("ERROR: UNABLE TO WATCH %s FOR CHANGES\n", this->filename.c_str());
+        return;
+    }
+
+    this->worker = std::thread(&CropWatcher::run, this);
+}
+
+CropWatcher::~CropWatcher() {
+    this->stopping = true;
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+
+#ifdef __linux__
+    if (this->notify >= 0) {
+        close(this->notify);
+    }
+#endif
+}
+
+bool CropWatcher::poll(CropReload* reload) {
+    // if the worker is publishing right now, just try again next frame
+    std::unique_lock<std::mutex> guard(this->lock, std::try_to_lock);
+    if (!guard.owns_lock() || this->pending.empty()) {
+        return false;
+    }
+
+    for (auto& pair : this->pending) {
+        reload->changes.push_back(pair.second);
+    }
+    this->pending.clear();
+
+    // the index is swapped over rather than copied, so picking it up costs nothing
+    reload->reordered = this->pendingReorder;
+    if (this->pendingReorder) {
+        reload->order.swap(this->pendingOrder);
+        reload->search.adopt(this->pendingSearch);
+        this->pendingOrder.clear();
+        this->pendingReorder = false;
+    }
+
+    return true;
+}
+
+void CropWatcher::run() {
+    while (this->waitForChange()) {
+        // editors often write in pieces, give them a moment to finish
+        std::this_thread::sleep_for(std::chrono::milliseconds(CROP_WATCH_SETTLE_MS));
+
+        // anything saved from here on is left waiting, so the loop reloads again once this one is done
+        this->consumeChanges();
+        this->reload();
+    }
+}
+
+#ifdef __linux__
+// inotify on the folder, since editors tend to save by replacing the file instead of writing into it
+bool CropWatcher::watch() {
+    std::filesystem::path path(this->filename);
+    std::string folder = path.has_parent_path() ? path.parent_path().string() : ".";
+
+    this->notify = inotify_init1(IN_NONBLOCK);
+    if (this->notify < 0 || inotify_add_watch(this->notify, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        if (this->notify >= 0) {
+            close(this->notify);
+            this->notify = -1;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+// reads every queued event without blocking, true if any of them were for the crop file
+static bool readEvents(int fd, const std::string& name) {
+    bool changed = false;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        for (char* at = buffer; at < buffer + length;) {
+            struct inotify_event* event = (struct inotify_event*) at;
+            if (event->len > 0 && name == event->name) {
+                changed = true;
+            }
+            at += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return changed;
+}
+
+bool CropWatcher::waitForChange() {
+    std::string name = std::filesystem::path(this->filename).filename().string();
+
+    // wake up every so often to check if we should stop
+    while (!this->stopping) {
+        struct pollfd request = {this->notify, POLLIN, 0};
+        if (::poll(&request, 1, CROP_WATCH_POLL_MS) > 0 && readEvents(this->notify, name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CropWatcher::consumeChanges() {
+    readEvents(this->notify, std::filesystem::path(this->filename).filename().string());
+}
+#else
+// everywhere else the modification time is checked a few times a second
+bool CropWatcher::watch() {
+    std::error_code error;
+    this->lastWrite = std::filesystem::last_write_time(this->filename, error);
+    return true;
+}
+
+bool CropWatcher::waitForChange() {
+    std::error_code error;
+
+    while (!this->stopping) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(CROP_WATCH_POLL_MS));
+
+        // compared against the time as of the last read, so a save during a reload still counts
+        auto now = std::filesystem::last_write_time(this->filename, error);
+        if (!error && now != this->lastWrite) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CropWatcher::consumeChanges() {
+    std::error_code error;
+    auto now = std::filesystem::last_write_time(this->filename, error);
+    if (!error) {
+        this->lastWrite = now;
+    }
+}
+#endif
+
+bool CropWatcher::readTable(std::unordered_map<std::string, CropChange>* latest) {
+    std::error_code error;
+    size_t size = std::filesystem::file_size(this->filename, error);
+
+    // big tables go through the same loader as startup, so a reload doesnt take longer than loading did
+    if (!error && size > CSV_FAST_THRESHOLD) {
+        std::vector<std::vector<CropRegistry::CropEntry*>> chunks;
+        if (!CropRegistry::parseCSVFast(this->filename, &chunks, &size)) {
+            return false;
+        }
+
+        for (auto& chunk : chunks) {
+            for (CropRegistry::CropEntry* entry : chunk) {
+                latest->try_emplace(entry->name, (CropChange){entry->name, entry->avgYield, entry->color, entry->growthDays, entry->plantingDay,
+                    entry->family, entry->spacing});
+                delete entry;
+            }
+        }
+
+        return true;
+    }
+
+    // same format as CropRegistry::loadFromCSV
+    try {
+        io::CSVReader<9> csvReader(this->filename);
+        csvReader.read_header(io::ignore_missing_column, "name", "yield", "red", "green", "blue", "days", "start", "family", "spacing");
+
+        std::string name;
+        double yield;
+        int red, green, blue;
+        int days = CROP_DEFAULT_GROWTH_DAYS;
+        int start = CROP_DEFAULT_PLANTING_DAY;
+        std::string family;
+        int spacing = CROP_DEFAULT_SPACING;
+
+        while (csvReader.read_row(name, yield, red, green, blue, days, start, family, spacing)) {
+            SDL_Color color = {(Uint8) red, (Uint8) green, (Uint8) blue, 0xFF};
+            latest->try_emplace(name, (CropChange){name, yield, color, std::max(1, days), std::max(0, start), family.empty() ? name : family,
+                std::max(CROP_MIN_SPACING, spacing)});
+        }
+    } catch (std::exception& error) {
+        // most likely caught halfway through a save, the next change will try again
+        printf("ERROR: UNABLE TO RELOAD %s\n", this->filename.c_str());
+        printf("ERROR MESSAGE: %s\n", error.what());
+        return false;
+    }
+
+    return true;
+}
+
+void CropWatcher::reload() {
+    std::unordered_map<std::string, CropChange> latest;
+    if (!this->readTable(&latest)) {
+        return;
+    }
+
+    // only crops that are new or whose values moved get published
+    std::vector<CropChange> changes;
+    bool added = false;
+    for (auto& pair : latest) {
+        CropChange& crop = pair.second;
+        auto found = this->known.find(pair.first);
+
+        if (found == this->known.end() || found->second.avgYield != crop.avgYield ||
+            memcmp(&found->second.color, &crop.color, sizeof(SDL_Color)) != 0 ||
+            found->second.growthDays != crop.growthDays || found->second.plantingDay != crop.plantingDay ||
+            found->second.family != crop.family || found->second.spacing != crop.spacing) {
+            added |= found == this->known.end();
+            changes.push_back(crop);
+            this->known[pair.first] = crop;
+        }
+    }
+
+    if (changes.empty()) {
+        return;
+    }
+
+    // new crops shift the order, which is sorted and indexed here instead of on the main thread
+    // known holds every crop the registry will have once these changes are in, removed ones included
+    std::vector<std::string> order;
+    SearchIndex search;
+    if (added) {
+        order.reserve(this->known.size());
+        for (auto& pair : this->known) {
+            if (pair.first != "NO SELECTION") {
+                order.push_back(pair.first);
+            }
+        }
+        std::sort(order.begin(), order.end());
+
+        // the null selection always comes first so it has an index of 0
+        if (this->known.count("NO SELECTION")) {
+            order.insert(order.begin(), "NO SELECTION");
+        }
+        search.build(order);
+    }
+
+    std::lock_guard<std::mutex> guard(this->lock);
+    for (auto& change : changes) {
+        this->pending[change.name] = change;
+    }
+
+    if (added) {
+        this->pendingOrder.swap(order);
+        this->pendingSearch.adopt(search);
+        this->pendingReorder = true;
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ *  workspace.cpp - keeping several farms open at once
+ *  written for GATSA's SLC '25 Software Development event
+*/
+
+#include "main.hpp"
+
+Workspace::Workspace(CropRegistry* registry, size_t memoryBudget, int autosaveDelay) {
+    this->registry = registry;
+    this->memoryBudget = memoryBudget;
+    this->autosaveDelay = autosaveDelay;
+}
+
+Workspace::~Workspace() {
+    for (auto& farm : this->resident) {
+        delete farm;
+    }
+
+    for (auto& farm : this->retiring) {
+        farm.thread.join();
+    }
+}
+
+void Workspace::add(std::string filename) {
+    if (std::find(this->files.begin(), this->files.end(), filename) == this->files.end()) {
+        this->files.push_back(filename);
+    }
+}
+
+Farm* Workspace::open(std::string filename) {
+    this->add(filename);
+
+    // already loaded, just move it to the front
+    for (auto it = this->resident.begin(); it != this->resident.end(); it++) {
+        if ((*it)->filename == filename) {
+            Farm* farm = *it;
+            this->resident.erase(it);
+            this->resident.push_front(farm);
+            return farm;
+        }
+    }
+
+    // if it was just evicted it might still be writing to its file
+    this->waitForRetired(filename);
+
+    Farm* farm = new Farm(filename, this->registry, this->autosaveDelay);
+    this->resident.push_front(farm);
+    this->evict();
+
+    return farm;
+}
+
+bool Workspace::isResident(const std::string& filename) {
+    for (auto& farm : this->resident) {
+        if (farm->filename == filename) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Workspace::setMemoryBudget(size_t bytes) {
+    this->memoryBudget = bytes;
+}
+
+void Workspace::setAutosaveDelay(int ms) {
+    this->autosaveDelay = ms;
+
+    for (auto& farm : this->resident) {
+        farm->autosave->setDebounce(ms);
+    }
+}
+
+size_t Workspace::memoryUse() {
+    size_t total = 0;
+    for (auto& farm : this->resident) {
+        total += farm->memoryUse();
+    }
+
+    return total;
+}
+
+void Workspace::evict() {
+    // threads of farms that are already gone would otherwise wait around until their file is opened again
+    for (auto it = this->retiring.begin(); it != this->retiring.end();) {
+        if (*it->done) {
+            it->thread.join();
+            it = this->retiring.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    size_t total = this->memoryUse();
+
+    // the front farm is the active one, so it is never let go
+    while (total > this->memoryBudget && this->resident.size() > 1) {
+        Farm* farm = this->resident.back();
+        this->resident.pop_back();
+        total -= farm->memoryUse();
+
+        // deleting a farm flushes its autosave, which can take a while on big farms
+        Retiring retired;
+        retired.filename = farm->filename;
+        retired.done = std::make_unique<std::atomic<bool>>(false);
+        std::atomic<bool>* done = retired.done.get();
+        retired.thread = std::thread([farm, done]() {
+            delete farm;
+            *done = true;
+        });
+        this->retiring.push_back(std::move(retired));
+    }
+}
+
+void Workspace::waitForRetired(std::string filename) {
+    for (auto it = this->retiring.begin(); it != this->retiring.end();) {
+        if (it->filename == filename) {
+            it->thread.join();
+            it = this->retiring.erase(it);
+        } else {
+            it++;
+        }
+    }
+}